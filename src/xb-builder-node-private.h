@@ -48,5 +48,13 @@ void
 xb_builder_node_add_token_idx(XbBuilderNode *self, guint32 tail_idx);
 GArray *
 xb_builder_node_get_token_idxs(XbBuilderNode *self);
+void
+xb_builder_node_tokenize_pending(XbBuilderNode *self);
+void
+xb_builder_node_set_tokenize_queue(GPtrArray *queue);
+void
+xb_builder_node_tokenize_queued(XbBuilderNode *self);
+void
+xb_builder_node_clear_tokens(XbBuilderNode *self);
 
 G_END_DECLS
@@ -39,12 +39,17 @@ typedef struct {
 	/* Most nodes will have no tokens */
 	GPtrArray *tokens;  /* (element-type utf8) (nullable) */
 	GArray *token_idxs; /* (element-type guint32) (nullable) */
+	gboolean tokenize_pending;
+	gboolean tokenize_queued;
 
 } XbBuilderNodePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE(XbBuilderNode, xb_builder_node, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (xb_builder_node_get_instance_private(o))
 
+/* the nodes to tokenize later, or %NULL to tokenize straight away */
+static GPrivate xb_builder_node_tokenize_queue = G_PRIVATE_INIT(NULL);
+
 static void
 xb_builder_node_attr_free(XbBuilderNodeAttr *attr);
 
@@ -311,6 +316,86 @@ xb_builder_node_parse_literal_text(XbBuilderNode *self, const gchar *text, gssiz
 	return g_string_free(tmp, FALSE);
 }
 
+static void
+xb_builder_node_tokenize_text_real(XbBuilderNode *self)
+{
+	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
+	const gchar *xml_lang = xb_builder_node_get_attr(self, "xml:lang");
+	guint ascii_tokens_sz;
+	guint tokens_sz;
+	g_autofree gchar **ascii_tokens = NULL;
+	g_autofree gchar **tokens = NULL;
+
+	if (priv->text == NULL)
+		return;
+	if (priv->tokens == NULL)
+		priv->tokens = g_ptr_array_new_with_free_func(g_free);
+
+	/* most text is ASCII, which does not need normalizing or transliterating */
+	if (xb_string_tokenize_ascii(priv->text, priv->tokens))
+		return;
+	tokens = g_str_tokenize_and_fold(priv->text, xml_lang, &ascii_tokens);
+	tokens_sz = g_strv_length(tokens);
+	ascii_tokens_sz = g_strv_length(ascii_tokens);
+
+	/* add all valid UTF-8 and ASCII tokens */
+	for (guint i = 0; i < tokens_sz; i++) {
+		if (!xb_string_token_valid(tokens[i])) {
+			g_free(g_steal_pointer(&tokens[i]));
+			continue;
+		}
+		g_ptr_array_add(priv->tokens, g_steal_pointer(&tokens[i]));
+	}
+	for (guint i = 0; i < ascii_tokens_sz; i++) {
+		if (!xb_string_token_valid(ascii_tokens[i])) {
+			g_free(g_steal_pointer(&ascii_tokens[i]));
+			continue;
+		}
+		g_ptr_array_add(priv->tokens, g_steal_pointer(&ascii_tokens[i]));
+	}
+}
+
+/* private: tokenizes the text now if xb_builder_node_tokenize_text() was
+ * called while the tokenize queue was set */
+void
+xb_builder_node_tokenize_pending(XbBuilderNode *self)
+{
+	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
+	if (!priv->tokenize_pending)
+		return;
+	priv->tokenize_pending = FALSE;
+	xb_builder_node_tokenize_text_real(self);
+}
+
+/* private: while @queue is set, xb_builder_node_tokenize_text() adds the node
+ * to @queue rather than tokenizing the text in this thread, and the caller
+ * has to call xb_builder_node_tokenize_queued() on each queued node */
+void
+xb_builder_node_set_tokenize_queue(GPtrArray *queue)
+{
+	g_private_set(&xb_builder_node_tokenize_queue, queue);
+}
+
+/* private: tokenizes a node from the tokenize queue; it is safe to call this
+ * from any thread, as long as each node is only used in one thread */
+void
+xb_builder_node_tokenize_queued(XbBuilderNode *self)
+{
+	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
+	xb_builder_node_tokenize_pending(self);
+	priv->tokenize_queued = FALSE;
+}
+
+/* private: removes the tokens, and the %XB_BUILDER_NODE_FLAG_TOKENIZE_TEXT flag */
+void
+xb_builder_node_clear_tokens(XbBuilderNode *self)
+{
+	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
+	priv->tokenize_pending = FALSE;
+	priv->flags &= ~XB_BUILDER_NODE_FLAG_TOKENIZE_TEXT;
+	g_clear_pointer(&priv->tokens, g_ptr_array_unref);
+}
+
 /**
  * xb_builder_node_tokenize_text:
  * @self: a #XbBuilderNode
@@ -336,38 +421,24 @@ void
 xb_builder_node_tokenize_text(XbBuilderNode *self)
 {
 	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
-	const gchar *xml_lang = xb_builder_node_get_attr(self, "xml:lang");
-	guint ascii_tokens_sz;
-	guint tokens_sz;
-	g_autofree gchar **ascii_tokens = NULL;
-	g_autofree gchar **tokens = NULL;
+	GPtrArray *queue = g_private_get(&xb_builder_node_tokenize_queue);
 
 	g_return_if_fail(XB_IS_BUILDER_NODE(self));
 
 	if (priv->text == NULL)
 		return;
-	tokens = g_str_tokenize_and_fold(priv->text, xml_lang, &ascii_tokens);
-
-	/* preallocate the right array size (and more for invalid tokens) */
-	tokens_sz = g_strv_length(tokens);
-	ascii_tokens_sz = g_strv_length(ascii_tokens);
-	if (priv->tokens == NULL)
-		priv->tokens = g_ptr_array_new_full(tokens_sz + ascii_tokens_sz, g_free);
 
-	/* add all valid UTF-8 and ASCII tokens */
-	for (guint i = 0; i < tokens_sz; i++) {
-		if (!xb_string_token_valid(tokens[i])) {
-			g_free(g_steal_pointer(&tokens[i]));
-			continue;
-		}
-		g_ptr_array_add(priv->tokens, g_steal_pointer(&tokens[i]));
-	}
-	for (guint i = 0; i < ascii_tokens_sz; i++) {
-		if (!xb_string_token_valid(ascii_tokens[i])) {
-			g_free(g_steal_pointer(&ascii_tokens[i]));
-			continue;
+	/* tokenized in parallel by xb_builder_compile() */
+	if (queue != NULL) {
+		/* the text may have been tokenized already, and could change */
+		xb_builder_node_tokenize_pending(self);
+		priv->tokenize_pending = TRUE;
+		if (!priv->tokenize_queued) {
+			priv->tokenize_queued = TRUE;
+			g_ptr_array_add(queue, g_object_ref(self));
 		}
-		g_ptr_array_add(priv->tokens, g_steal_pointer(&ascii_tokens[i]));
+	} else {
+		xb_builder_node_tokenize_text_real(self);
 	}
 
 	/* add this so we can set XbSiloNodeFlag.TOKENIZE_TEXT */
@@ -392,6 +463,7 @@ xb_builder_node_set_text(XbBuilderNode *self, const gchar *text, gssize text_len
 	g_return_if_fail(XB_IS_BUILDER_NODE(self));
 
 	/* old data */
+	xb_builder_node_tokenize_pending(self);
 	g_free(priv->text);
 	priv->text = xb_builder_node_parse_literal_text(self, text, text_len);
 	priv->flags |= XB_BUILDER_NODE_FLAG_HAS_TEXT;
@@ -1205,6 +1277,7 @@ xb_builder_node_add_token(XbBuilderNode *self, const gchar *token)
 	g_return_if_fail(self != NULL);
 	g_return_if_fail(token != NULL);
 
+	xb_builder_node_tokenize_pending(self);
 	if (priv->tokens == NULL)
 		priv->tokens = g_ptr_array_new_with_free_func(g_free);
 	g_ptr_array_add(priv->tokens, g_strdup(token));
@@ -1225,6 +1298,7 @@ xb_builder_node_get_tokens(XbBuilderNode *self)
 {
 	XbBuilderNodePrivate *priv = GET_PRIVATE(self);
 	g_return_val_if_fail(self != NULL, NULL);
+	xb_builder_node_tokenize_pending(self);
 	return priv->tokens;
 }
 
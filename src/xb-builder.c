@@ -42,10 +42,19 @@ typedef struct {
 	XbBuilderCompileFlags compile_flags;
 	XbBuilderSourceFlags source_flags;
 	GHashTable *strtab_hash;
+	GHashTable *tokens_hash; /* token to number of nodes, then to strtab idx */
 	GString *strtab;
+	GArray *tokentab;	   /* of guint32 */
+	GArray *foldtab;	   /* of XbBuilderFoldPair */
+	GPtrArray *tokenize_queue; /* of XbBuilderNode */
 	GPtrArray *locales;
 } XbBuilderCompileHelper;
 
+typedef struct {
+	guint32 offset;
+	guint32 folded;
+} XbBuilderFoldPair;
+
 static guint32
 xb_builder_compile_add_to_strtab(XbBuilderCompileHelper *helper, const gchar *str)
 {
@@ -379,11 +388,176 @@ xb_builder_strtab_text_cb(XbBuilderNode *bn, gpointer user_data)
 	return FALSE;
 }
 
+static void
+xb_builder_compile_add_folded(XbBuilderCompileHelper *helper, const gchar *str, guint32 idx)
+{
+	XbBuilderFoldPair pair = {.offset = idx};
+	g_autofree gchar *folded = g_utf8_strdown(str, -1);
+
+	/* already lower case */
+	if (g_strcmp0(folded, str) == 0)
+		return;
+	pair.folded = xb_builder_compile_add_to_strtab(helper, folded);
+	g_array_append_val(helper->foldtab, pair);
+}
+
+static gboolean
+xb_builder_strtab_fold_cb(XbBuilderNode *bn, gpointer user_data)
+{
+	GPtrArray *attrs;
+	XbBuilderCompileHelper *helper = (XbBuilderCompileHelper *)user_data;
+
+	/* root node */
+	if (xb_builder_node_get_element(bn) == NULL)
+		return FALSE;
+	if (xb_builder_node_has_flag(bn, XB_BUILDER_NODE_FLAG_IGNORE))
+		return FALSE;
+	attrs = xb_builder_node_get_attrs(bn);
+	for (guint i = 0; attrs != NULL && i < attrs->len; i++) {
+		XbBuilderNodeAttr *attr = g_ptr_array_index(attrs, i);
+		xb_builder_compile_add_folded(helper, attr->value, attr->value_idx);
+	}
+	if (xb_builder_node_get_text(bn) != NULL) {
+		xb_builder_compile_add_folded(helper,
+					      xb_builder_node_get_text(bn),
+					      xb_builder_node_get_text_idx(bn));
+	}
+	return FALSE;
+}
+
+static gint
+xb_builder_fold_pair_cmp(gconstpointer a, gconstpointer b)
+{
+	const XbBuilderFoldPair *pair1 = a;
+	const XbBuilderFoldPair *pair2 = b;
+	if (pair1->offset < pair2->offset)
+		return -1;
+	if (pair1->offset > pair2->offset)
+		return 1;
+	return 0;
+}
+
+/* the same string may be used by many nodes, so only keep the first pair */
+static void
+xb_builder_foldtab_write(XbBuilderCompileHelper *helper, GString *buf)
+{
+	guint32 pairs = 0;
+	g_autoptr(GArray) foldtab = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+	g_array_sort(helper->foldtab, xb_builder_fold_pair_cmp);
+	g_array_append_val(foldtab, pairs);
+	for (guint i = 0; i < helper->foldtab->len; i++) {
+		XbBuilderFoldPair *pair = &g_array_index(helper->foldtab, XbBuilderFoldPair, i);
+		if (i > 0 &&
+		    g_array_index(helper->foldtab, XbBuilderFoldPair, i - 1).offset == pair->offset)
+			continue;
+		g_array_append_val(foldtab, pair->offset);
+		g_array_append_val(foldtab, pair->folded);
+		pairs++;
+	}
+	g_array_index(foldtab, guint32, XB_SILO_FOLDTAB_PAIRS) = pairs;
+	XB_SILO_APPENDBUF(buf, foldtab->data, foldtab->len * sizeof(guint32));
+}
+
+/* the stems are added after all the tokens, so that search(text(),stem('foo'))
+ * can compare the stemmed search token with the stems in the silo */
+static gboolean
+xb_builder_stem_tokens_cb(XbBuilderNode *bn, gpointer user_data)
+{
+	GPtrArray *tokens = xb_builder_node_get_tokens(bn);
+	guint tokens_len;
+
+	if (tokens == NULL)
+		return FALSE;
+	tokens_len = tokens->len;
+	for (guint i = 0; i < tokens_len; i++) {
+		const gchar *tmp = g_ptr_array_index(tokens, i);
+		gboolean seen = FALSE;
+		g_autofree gchar *stem = NULL;
+
+		if (tmp == NULL)
+			continue;
+		stem = xb_string_stem(tmp);
+		if (!xb_string_token_valid(stem))
+			continue;
+		for (guint j = 0; j < tokens->len && !seen; j++)
+			seen = g_strcmp0(g_ptr_array_index(tokens, j), stem) == 0;
+		if (!seen)
+			xb_builder_node_add_token(bn, stem);
+	}
+	return FALSE;
+}
+
+static gboolean
+xb_builder_strtab_tokens_collect_cb(XbBuilderNode *bn, gpointer user_data)
+{
+	XbBuilderCompileHelper *helper = (XbBuilderCompileHelper *)user_data;
+	GPtrArray *tokens = xb_builder_node_get_tokens(bn);
+
+	/* root node */
+	if (xb_builder_node_get_element(bn) == NULL)
+		return FALSE;
+	if (xb_builder_node_has_flag(bn, XB_BUILDER_NODE_FLAG_IGNORE))
+		return FALSE;
+	if (tokens == NULL)
+		return FALSE;
+	for (guint i = 0; i < MIN(tokens->len, XB_OPCODE_TOKEN_MAX); i++) {
+		const gchar *tmp = g_ptr_array_index(tokens, i);
+		gboolean seen = FALSE;
+		guint cnt;
+		if (tmp == NULL)
+			continue;
+
+		/* only count each node once */
+		for (guint j = 0; j < i && !seen; j++)
+			seen = g_strcmp0(g_ptr_array_index(tokens, j), tmp) == 0;
+		if (seen)
+			continue;
+		cnt = GPOINTER_TO_UINT(g_hash_table_lookup(helper->tokens_hash, tmp));
+		g_hash_table_insert(helper->tokens_hash, (gpointer)tmp, GUINT_TO_POINTER(cnt + 1));
+	}
+	return FALSE;
+}
+
+static gint
+xb_builder_strtab_tokens_sort_cb(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const gchar **)a, *(const gchar **)b);
+}
+
+/* all the tokens are appended to the end of the strtab in sorted order, even
+ * if the same string was already added, so the tokens starting with a prefix
+ * are found in one contiguous range of offsets; the number of nodes with each
+ * token is added to the tokentab in the same order */
+static void
+xb_builder_strtab_tokens_add(XbBuilderCompileHelper *helper)
+{
+	g_autoptr(GPtrArray) tokens = g_ptr_array_new();
+	GHashTableIter iter;
+	gpointer key;
+
+	g_hash_table_iter_init(&iter, helper->tokens_hash);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		g_ptr_array_add(tokens, key);
+	g_ptr_array_sort(tokens, xb_builder_strtab_tokens_sort_cb);
+	for (guint i = 0; i < tokens->len; i++) {
+		const gchar *tmp = g_ptr_array_index(tokens, i);
+		guint32 cnt = GPOINTER_TO_UINT(g_hash_table_lookup(helper->tokens_hash, tmp));
+		g_array_append_val(helper->tokentab, cnt);
+		g_hash_table_insert(helper->tokens_hash,
+				    (gpointer)tmp,
+				    GUINT_TO_POINTER(helper->strtab->len));
+		XB_SILO_APPENDBUF(helper->strtab, tmp, strlen(tmp) + 1);
+	}
+}
+
 static gboolean
 xb_builder_strtab_tokens_cb(XbBuilderNode *bn, gpointer user_data)
 {
 	XbBuilderCompileHelper *helper = (XbBuilderCompileHelper *)user_data;
 	GPtrArray *tokens = xb_builder_node_get_tokens(bn);
+	guint32 *totals = (guint32 *)helper->tokentab->data;
+	guint cnt = 0;
 
 	/* root node */
 	if (xb_builder_node_get_element(bn) == NULL)
@@ -396,7 +570,14 @@ xb_builder_strtab_tokens_cb(XbBuilderNode *bn, gpointer user_data)
 		const gchar *tmp = g_ptr_array_index(tokens, i);
 		if (tmp == NULL)
 			continue;
-		xb_builder_node_add_token_idx(bn, xb_builder_compile_add_to_strtab(helper, tmp));
+		xb_builder_node_add_token_idx(
+		    bn,
+		    GPOINTER_TO_UINT(g_hash_table_lookup(helper->tokens_hash, tmp)));
+		cnt++;
+	}
+	if (cnt > 0) {
+		totals[XB_SILO_TOKENTAB_NODES]++;
+		totals[XB_SILO_TOKENTAB_TOKENS] += cnt;
 	}
 	return FALSE;
 }
@@ -613,11 +794,94 @@ xb_builder_nodetab_fix_cb(XbBuilderNode *bn, gpointer user_data)
 	return FALSE;
 }
 
+/* the minimum number of nodes to tokenize in each thread */
+#define XB_BUILDER_TOKENIZE_CHUNK_MIN 256
+
+typedef struct {
+	GPtrArray *nodes;
+	guint start;
+	guint end;
+} XbBuilderTokenizeChunk;
+
+static void
+xb_builder_tokenize_chunk_cb(gpointer data, gpointer user_data)
+{
+	XbBuilderTokenizeChunk *chunk = (XbBuilderTokenizeChunk *)data;
+	for (guint i = chunk->start; i < chunk->end; i++)
+		xb_builder_node_tokenize_queued(g_ptr_array_index(chunk->nodes, i));
+}
+
+/* each node only uses its own text and attributes, and the tokens are added
+ * to the strtab afterwards in document order, so the silo is the same */
+static void
+xb_builder_tokenize_queue(XbBuilderCompileHelper *helper)
+{
+	GPtrArray *nodes = helper->tokenize_queue;
+	GThreadPool *pool;
+	guint n_chunks;
+	guint chunk_sz;
+	g_autofree XbBuilderTokenizeChunk *chunks = NULL;
+
+	/* nothing else can be added */
+	xb_builder_node_set_tokenize_queue(NULL);
+
+	/* not worth it */
+	n_chunks = MIN((guint)g_get_num_processors(), nodes->len / XB_BUILDER_TOKENIZE_CHUNK_MIN);
+	if (n_chunks < 2) {
+		for (guint i = 0; i < nodes->len; i++)
+			xb_builder_node_tokenize_queued(g_ptr_array_index(nodes, i));
+		return;
+	}
+	chunk_sz = (nodes->len + n_chunks - 1) / n_chunks;
+	chunks = g_new0(XbBuilderTokenizeChunk, n_chunks);
+	for (guint j = 0; j < n_chunks; j++) {
+		chunks[j].nodes = nodes;
+		chunks[j].start = MIN(j * chunk_sz, nodes->len);
+		chunks[j].end = MIN(chunks[j].start + chunk_sz, nodes->len);
+	}
+
+	/* wait for all the chunks to finish */
+	pool = g_thread_pool_new(xb_builder_tokenize_chunk_cb, NULL, n_chunks, FALSE, NULL);
+	for (guint j = 0; j < n_chunks; j++) {
+		if (pool == NULL || !g_thread_pool_push(pool, &chunks[j], NULL))
+			xb_builder_tokenize_chunk_cb(&chunks[j], NULL);
+	}
+	if (pool != NULL)
+		g_thread_pool_free(pool, FALSE, TRUE);
+}
+
+/* non-ASCII text is tokenized even if no fixup asked for it, so that search()
+ * does not have to normalize the text for every query */
+static gboolean
+xb_builder_tokenize_non_ascii_cb(XbBuilderNode *bn, gpointer user_data)
+{
+	GPtrArray *nodes = (GPtrArray *)user_data;
+	const gchar *text = xb_builder_node_get_text(bn);
+
+	/* root node */
+	if (xb_builder_node_get_element(bn) == NULL)
+		return FALSE;
+	if (xb_builder_node_has_flag(bn, XB_BUILDER_NODE_FLAG_IGNORE))
+		return FALSE;
+	if (text == NULL || g_str_is_ascii(text))
+		return FALSE;
+	if (xb_builder_node_has_flag(bn, XB_BUILDER_NODE_FLAG_TOKENIZE_TEXT))
+		return FALSE;
+	xb_builder_node_tokenize_text(bn);
+	g_ptr_array_add(nodes, g_object_ref(bn));
+	return FALSE;
+}
+
 static void
 xb_builder_compile_helper_free(XbBuilderCompileHelper *helper)
 {
+	xb_builder_node_set_tokenize_queue(NULL);
 	g_hash_table_unref(helper->strtab_hash);
+	g_hash_table_unref(helper->tokens_hash);
 	g_string_free(helper->strtab, TRUE);
+	g_array_unref(helper->tokentab);
+	g_array_unref(helper->foldtab);
+	g_ptr_array_unref(helper->tokenize_queue);
 	g_object_unref(helper->root);
 	g_free(helper);
 }
@@ -740,6 +1004,12 @@ xb_builder_watch_sources(XbBuilder *self, GCancellable *cancellable, GError **er
  *
  * Compiles a #XbSilo.
  *
+ * If @flags includes %XB_BUILDER_COMPILE_FLAG_TOKENIZE_NON_ASCII then text
+ * that is not ASCII is tokenized even if no fixup asked for it. search() on
+ * that text then matches if any of the search tokens is the prefix of a token,
+ * rather than needing all of the search tokens to match. Text with more tokens
+ * than can be stored in a node is not tokenized, and is matched as before.
+ *
  * Returns: (transfer full): a #XbSilo, or %NULL for error
  *
  * Since: 0.1.0
@@ -759,13 +1029,17 @@ xb_builder_compile(XbBuilder *self,
 	    .version = XB_SILO_VERSION,
 	    .strtab = 0,
 	    .strtab_ntags = 0,
-	    .padding = {0x0},
+	    .flags = XB_SILO_HEADER_FLAG_NONE,
 	    .guid = {0x0},
+	    .strtab_tokens = 0,
+	    .tokentab = 0,
+	    .foldtab = 0,
 	};
 	XbBuilderNodetabHelper nodetab_helper = {
 	    .buf = NULL,
 	};
 	g_autoptr(GPtrArray) nodes_to_destroy = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	g_autoptr(GPtrArray) nodes_non_ascii = NULL;
 	g_autoptr(GTimer) timer = xb_silo_start_profile(priv->silo);
 	g_autoptr(XbBuilderCompileHelper) helper = NULL;
 
@@ -794,6 +1068,12 @@ xb_builder_compile(XbBuilder *self,
 	helper->locales = priv->locales;
 	helper->strtab = g_string_new(NULL);
 	helper->strtab_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	helper->tokens_hash = g_hash_table_new(g_str_hash, g_str_equal);
+	helper->tokentab = g_array_new(FALSE, TRUE, sizeof(guint32));
+	g_array_set_size(helper->tokentab, XB_SILO_TOKENTAB_DF);
+	helper->foldtab = g_array_new(FALSE, FALSE, sizeof(XbBuilderFoldPair));
+	helper->tokenize_queue = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	xb_builder_node_set_tokenize_queue(helper->tokenize_queue);
 
 	/* build node tree */
 	for (guint i = 0; i < priv->sources->len; i++) {
@@ -862,6 +1142,39 @@ xb_builder_compile(XbBuilder *self,
 		xb_builder_node_add_child(helper->root, bn);
 	}
 
+	/* tokenize the text of the nodes from the fixups */
+	nodes_non_ascii = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	if (flags & XB_BUILDER_COMPILE_FLAG_TOKENIZE_NON_ASCII) {
+		hdr.flags |= XB_SILO_HEADER_FLAG_TOKENIZE_NON_ASCII;
+		xb_builder_node_traverse(helper->root,
+					 G_PRE_ORDER,
+					 G_TRAVERSE_ALL,
+					 -1,
+					 xb_builder_tokenize_non_ascii_cb,
+					 nodes_non_ascii);
+	}
+	xb_builder_tokenize_queue(helper);
+	xb_silo_add_profile(priv->silo, timer, "tokenizing %u nodes", helper->tokenize_queue->len);
+
+	/* only some of the tokens can be stored, so search() would miss matches */
+	for (guint i = 0; i < nodes_non_ascii->len; i++) {
+		XbBuilderNode *bn = g_ptr_array_index(nodes_non_ascii, i);
+		GPtrArray *tokens = xb_builder_node_get_tokens(bn);
+		if (tokens != NULL && tokens->len > XB_OPCODE_TOKEN_MAX)
+			xb_builder_node_clear_tokens(bn);
+	}
+
+	/* the stems change the size of the nodes, so add them first */
+	if (flags & XB_BUILDER_COMPILE_FLAG_STEM_TOKENS) {
+		xb_builder_node_traverse(helper->root,
+					 G_PRE_ORDER,
+					 G_TRAVERSE_ALL,
+					 -1,
+					 xb_builder_stem_tokens_cb,
+					 helper);
+		xb_silo_add_profile(priv->silo, timer, "stemming tokens");
+	}
+
 	/* get the size of the nodetab */
 	xb_builder_node_traverse(helper->root,
 				 G_PRE_ORDER,
@@ -902,6 +1215,26 @@ xb_builder_compile(XbBuilder *self,
 				 xb_builder_strtab_text_cb,
 				 helper);
 	xb_silo_add_profile(priv->silo, timer, "adding strtab text");
+	if (flags & XB_BUILDER_COMPILE_FLAG_FOLD_CASE) {
+		xb_builder_node_traverse(helper->root,
+					 G_PRE_ORDER,
+					 G_TRAVERSE_ALL,
+					 -1,
+					 xb_builder_strtab_fold_cb,
+					 helper);
+		xb_silo_add_profile(priv->silo, timer, "adding strtab lower case");
+	}
+	xb_builder_node_traverse(helper->root,
+				 G_PRE_ORDER,
+				 G_TRAVERSE_ALL,
+				 -1,
+				 xb_builder_strtab_tokens_collect_cb,
+				 helper);
+	/* the sorted tokens are added after every other string, even if they
+	 * are already in the strtab, so the node values keep the only offset
+	 * before this and can still be compared by offset */
+	hdr.strtab_tokens = helper->strtab->len;
+	xb_builder_strtab_tokens_add(helper);
 	xb_builder_node_traverse(helper->root,
 				 G_PRE_ORDER,
 				 G_TRAVERSE_ALL,
@@ -912,6 +1245,8 @@ xb_builder_compile(XbBuilder *self,
 
 	/* add the initial header */
 	hdr.strtab = nodetabsz;
+	hdr.tokentab = nodetabsz + helper->strtab->len;
+	hdr.foldtab = hdr.tokentab + helper->tokentab->len * sizeof(guint32);
 	if (priv->guid->len > 0) {
 		XbGuid guid_tmp;
 		xb_guid_compute_for_data(&guid_tmp,
@@ -939,6 +1274,15 @@ xb_builder_compile(XbBuilder *self,
 	XB_SILO_APPENDBUF(buf, helper->strtab->str, helper->strtab->len);
 	xb_silo_add_profile(priv->silo, timer, "appending strtab");
 
+	/* append the token statistics */
+	XB_SILO_APPENDBUF(buf,
+			  helper->tokentab->data,
+			  helper->tokentab->len * sizeof(guint32));
+
+	/* append the lower case strings */
+	if (flags & XB_BUILDER_COMPILE_FLAG_FOLD_CASE)
+		xb_builder_foldtab_write(helper, buf);
+
 	/* create data */
 	blob = g_bytes_new(buf->str, buf->len);
 	if (!xb_silo_load_from_bytes(priv->silo, blob, XB_SILO_LOAD_FLAG_NONE, error))
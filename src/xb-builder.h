@@ -40,17 +40,23 @@ struct _XbBuilderClass {
  * @XB_BUILDER_COMPILE_FLAG_WATCH_BLOB:		Watch the XMLB file for changes
  * @XB_BUILDER_COMPILE_FLAG_IGNORE_GUID:	Ignore the cache GUID value
  * @XB_BUILDER_COMPILE_FLAG_SINGLE_ROOT:	Require at most one root node
+ * @XB_BUILDER_COMPILE_FLAG_STEM_TOKENS:	Also store the stem of each token
+ * @XB_BUILDER_COMPILE_FLAG_FOLD_CASE:		Also store the lower case text and attribute values
+ * @XB_BUILDER_COMPILE_FLAG_TOKENIZE_NON_ASCII:	Tokenize all the text that is not ASCII
  *
  * The flags for converting to XML.
  **/
 typedef enum {
-	XB_BUILDER_COMPILE_FLAG_NONE = 0,		 /* Since: 0.1.0 */
-	XB_BUILDER_COMPILE_FLAG_NATIVE_LANGS = 1 << 1,	 /* Since: 0.1.0 */
-	XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID = 1 << 2, /* Since: 0.1.0 */
-	XB_BUILDER_COMPILE_FLAG_SINGLE_LANG = 1 << 3,	 /* Since: 0.1.0 */
-	XB_BUILDER_COMPILE_FLAG_WATCH_BLOB = 1 << 4,	 /* Since: 0.1.0 */
-	XB_BUILDER_COMPILE_FLAG_IGNORE_GUID = 1 << 5,	 /* Since: 0.1.7 */
-	XB_BUILDER_COMPILE_FLAG_SINGLE_ROOT = 1 << 6,	 /* Since: 0.3.4 */
+	XB_BUILDER_COMPILE_FLAG_NONE = 0,		     /* Since: 0.1.0 */
+	XB_BUILDER_COMPILE_FLAG_NATIVE_LANGS = 1 << 1,	     /* Since: 0.1.0 */
+	XB_BUILDER_COMPILE_FLAG_IGNORE_INVALID = 1 << 2,     /* Since: 0.1.0 */
+	XB_BUILDER_COMPILE_FLAG_SINGLE_LANG = 1 << 3,	     /* Since: 0.1.0 */
+	XB_BUILDER_COMPILE_FLAG_WATCH_BLOB = 1 << 4,	     /* Since: 0.1.0 */
+	XB_BUILDER_COMPILE_FLAG_IGNORE_GUID = 1 << 5,	     /* Since: 0.1.7 */
+	XB_BUILDER_COMPILE_FLAG_SINGLE_ROOT = 1 << 6,	     /* Since: 0.3.4 */
+	XB_BUILDER_COMPILE_FLAG_STEM_TOKENS = 1 << 7,	     /* Since: 0.3.11 */
+	XB_BUILDER_COMPILE_FLAG_FOLD_CASE = 1 << 8,	     /* Since: 0.3.11 */
+	XB_BUILDER_COMPILE_FLAG_TOKENIZE_NON_ASCII = 1 << 9, /* Since: 0.3.11 */
 	/*< private >*/
 	XB_BUILDER_COMPILE_FLAG_LAST
 } XbBuilderCompileFlags;
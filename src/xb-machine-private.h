@@ -19,4 +19,28 @@ xb_machine_stack_pop_two(XbMachine *self,
 void
 xb_machine_opcode_tokenize(XbMachine *self, XbOpcode *op);
 
+typedef struct {
+	guint64 calls;
+	gint64 elapsed; /* µs */
+} XbMachineMethodProfile;
+
+guint
+xb_machine_get_method_count(XbMachine *self);
+const gchar *
+xb_machine_get_method_name(XbMachine *self, guint idx);
+XbStack *
+xb_machine_opcodes_bind(XbMachine *self,
+			XbStack *opcodes,
+			XbValueBindings *bindings,
+			guint *bindings_idx,
+			GError **error);
+gboolean
+xb_machine_run_with_profile(XbMachine *self,
+			    XbStack *opcodes,
+			    XbValueBindings *bindings,
+			    gboolean *result,
+			    gpointer exec_data,
+			    XbMachineMethodProfile *profile,
+			    GError **error);
+
 G_END_DECLS
@@ -27,7 +27,8 @@ typedef struct {
 	GPtrArray *operators;	   /* of XbMachineOperator */
 	GPtrArray *text_handlers;  /* of XbMachineTextHandlerItem */
 	GHashTable *opcode_fixup;  /* of str[XbMachineOpcodeFixupItem] */
-	GHashTable *opcode_tokens; /* of utf8 */
+	GHashTable *opcode_tokens; /* (mutex opcode_tokens_mutex): of utf8 */
+	GMutex opcode_tokens_mutex;
 	guint stack_size;
 } XbMachinePrivate;
 
@@ -686,6 +687,184 @@ xb_machine_opcodes_optimize(XbMachine *self, XbStack *opcodes, GError **error)
 	return TRUE;
 }
 
+/* Returns the index of the first opcode of the expression that ends at @idx,
+ * or %G_MAXUINT if the function arguments are not all present */
+static guint
+xb_machine_opcodes_get_start(XbMachine *self, XbStack *opcodes, guint idx)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	XbOpcode *op = xb_stack_peek(opcodes, idx);
+	XbMachineMethodItem *item;
+	guint start = idx;
+
+	if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_FUNCTION)
+		return start;
+	item = g_ptr_array_index(priv->methods, xb_opcode_get_val(op));
+	for (guint i = 0; i < item->n_opcodes; i++) {
+		if (start == 0)
+			return G_MAXUINT;
+		start = xb_machine_opcodes_get_start(self, opcodes, start - 1);
+		if (start == G_MAXUINT)
+			return G_MAXUINT;
+	}
+	return start;
+}
+
+static const gchar *
+xb_machine_opcode_get_func_name(XbMachine *self, XbOpcode *op)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	XbMachineMethodItem *item;
+	if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_FUNCTION)
+		return NULL;
+	item = g_ptr_array_index(priv->methods, xb_opcode_get_val(op));
+	return item->name;
+}
+
+/* a rough relative cost of running each opcode for every node */
+static guint
+xb_machine_opcodes_get_cost(XbMachine *self, XbStack *opcodes, guint start, guint end)
+{
+	guint cost = 0;
+	for (guint i = start; i < end; i++) {
+		const gchar *name = xb_machine_opcode_get_func_name(self, xb_stack_peek(opcodes, i));
+		if (name == NULL)
+			continue;
+		if (g_strcmp0(name, "search") == 0 || g_strcmp0(name, "search-fuzzy") == 0 ||
+		    g_strcmp0(name, "stem") == 0) {
+			cost += 50;
+		} else if (g_strcmp0(name, "contains") == 0 || g_strcmp0(name, "count") == 0 ||
+			   g_strcmp0(name, "starts-with") == 0 ||
+			   g_strcmp0(name, "ends-with") == 0 ||
+			   g_strcmp0(name, "lower-case") == 0 ||
+			   g_strcmp0(name, "upper-case") == 0 || g_strcmp0(name, "string") == 0 ||
+			   g_strcmp0(name, "number") == 0 ||
+			   g_strcmp0(name, "string-length") == 0) {
+			cost += 10;
+		} else {
+			cost += 1;
+		}
+	}
+	return cost;
+}
+
+static gboolean
+xb_machine_opcodes_has_binding(XbStack *opcodes, guint start, guint end)
+{
+	for (guint i = start; i < end; i++) {
+		if (xb_opcode_is_binding(xb_stack_peek(opcodes, i)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+xb_machine_opcode_is_and_or(XbMachine *self, XbOpcode *op)
+{
+	const gchar *name = xb_machine_opcode_get_func_name(self, op);
+	return g_strcmp0(name, "and") == 0 || g_strcmp0(name, "or") == 0;
+}
+
+/* appends the indexes of the expression ending at @idx to @order, running the
+ * cheaper argument of and() and or() first */
+static void
+xb_machine_opcodes_reorder_expr(XbMachine *self, XbStack *opcodes, guint idx, GArray *order)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	XbOpcode *op = xb_stack_peek(opcodes, idx);
+	XbMachineMethodItem *item;
+	guint *args;
+	guint start = idx;
+
+	if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_FUNCTION) {
+		g_array_append_val(order, idx);
+		return;
+	}
+
+	/* find the last opcode of each argument */
+	item = g_ptr_array_index(priv->methods, xb_opcode_get_val(op));
+	args = g_newa(guint, item->n_opcodes + 1);
+	for (guint i = item->n_opcodes; i > 0; i--) {
+		args[i - 1] = start - 1;
+		start = xb_machine_opcodes_get_start(self, opcodes, start - 1);
+	}
+
+	/* bound values are consumed in order, so only swap if that would be
+	 * unchanged */
+	if (xb_machine_opcode_is_and_or(self, op)) {
+		guint mid = args[0] + 1;
+		guint cost1 = xb_machine_opcodes_get_cost(self, opcodes, start, mid);
+		guint cost2 = xb_machine_opcodes_get_cost(self, opcodes, mid, idx);
+		if (cost2 < cost1 && !(xb_machine_opcodes_has_binding(opcodes, start, mid) &&
+				       xb_machine_opcodes_has_binding(opcodes, mid, idx))) {
+			guint tmp = args[0];
+			args[0] = args[1];
+			args[1] = tmp;
+		}
+	}
+	for (guint i = 0; i < item->n_opcodes; i++)
+		xb_machine_opcodes_reorder_expr(self, opcodes, args[i], order);
+	g_array_append_val(order, idx);
+}
+
+static void
+xb_machine_opcodes_reorder(XbMachine *self, XbStack *opcodes)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	guint sz = xb_stack_get_size(opcodes);
+	g_autoptr(GArray) order = NULL;
+	g_autofree XbOpcode *tmp = NULL;
+
+	/* the opcodes have to be exactly one expression */
+	if (sz == 0 || xb_machine_opcodes_get_start(self, opcodes, sz - 1) != 0)
+		return;
+
+	/* reordering the opcodes moves the ownership of any data */
+	order = g_array_sized_new(FALSE, FALSE, sizeof(guint), sz);
+	xb_machine_opcodes_reorder_expr(self, opcodes, sz - 1, order);
+	tmp = g_new(XbOpcode, sz);
+	for (guint i = 0; i < sz; i++)
+		tmp[i] = *xb_stack_peek(opcodes, g_array_index(order, guint, i));
+	for (guint i = 0; i < sz; i++)
+		*xb_stack_peek(opcodes, i) = tmp[i];
+
+	/* debug */
+	if (priv->debug_flags & XB_MACHINE_DEBUG_FLAG_SHOW_OPTIMIZER) {
+		g_autofree gchar *str = xb_stack_to_string(opcodes);
+		g_debug("after reordering: %s", str);
+	}
+}
+
+/* the last opcode of the first argument of and() or or() can jump over the
+ * second argument if the result is already decided */
+static void
+xb_machine_opcodes_add_jumps(XbMachine *self, XbStack *opcodes)
+{
+	guint sz = xb_stack_get_size(opcodes);
+
+	for (guint i = 0; i < sz; i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		op->jump = XB_OPCODE_JUMP_NONE;
+		op->jump_idx = 0;
+	}
+	for (guint i = 0; i < sz; i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		const gchar *name = xb_machine_opcode_get_func_name(self, op);
+		XbOpcode *op_arg1;
+		guint mid;
+
+		if (g_strcmp0(name, "and") != 0 && g_strcmp0(name, "or") != 0)
+			continue;
+		if (xb_machine_opcodes_get_start(self, opcodes, i) == G_MAXUINT)
+			continue;
+		mid = xb_machine_opcodes_get_start(self, opcodes, i - 1);
+		op_arg1 = xb_stack_peek(opcodes, mid - 1);
+		op_arg1->jump = g_strcmp0(name, "and") == 0 ? XB_OPCODE_JUMP_IF_FALSE
+							     : XB_OPCODE_JUMP_IF_TRUE;
+		op_arg1->jump_idx = i;
+	}
+}
+
 static gsize
 xb_machine_parse_text(XbMachine *self,
 		      XbStack *opcodes,
@@ -756,6 +935,49 @@ xb_machine_parse_text(XbMachine *self,
 	return 0;
 }
 
+/* runs the fixups and the optimizer on the parsed @opcodes */
+static gboolean
+xb_machine_opcodes_finish(XbMachine *self,
+			  XbStack *opcodes,
+			  XbMachineParseFlags flags,
+			  GError **error)
+{
+	XbMachineOpcodeFixupItem *item;
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	g_autofree gchar *opcodes_sig = NULL;
+
+	/* do any fixups */
+	opcodes_sig = xb_machine_get_opcodes_sig(self, opcodes);
+	if (priv->debug_flags & XB_MACHINE_DEBUG_FLAG_SHOW_OPTIMIZER)
+		g_debug("opcodes_sig=%s", opcodes_sig);
+	item = g_hash_table_lookup(priv->opcode_fixup, opcodes_sig);
+	if (item != NULL) {
+		if (!item->fixup_cb(self, opcodes, item->user_data, error))
+			return FALSE;
+	}
+
+	/* optimize */
+	if (flags & XB_MACHINE_PARSE_FLAG_OPTIMIZE) {
+		for (guint i = 0; i < 10; i++) {
+			guint oldsz = xb_stack_get_size(opcodes);
+
+			/* Is the stack optimal already? */
+			if (oldsz == 1)
+				break;
+
+			if (!xb_machine_opcodes_optimize(self, opcodes, error))
+				return FALSE;
+			if (oldsz == xb_stack_get_size(opcodes))
+				break;
+		}
+		xb_machine_opcodes_reorder(self, opcodes);
+	}
+
+	/* allow skipping the second argument of and() and or() */
+	xb_machine_opcodes_add_jumps(self, opcodes);
+	return TRUE;
+}
+
 /**
  * xb_machine_parse_full:
  * @self: a #XbMachine
@@ -779,11 +1001,9 @@ xb_machine_parse_full(XbMachine *self,
 		      XbMachineParseFlags flags,
 		      GError **error)
 {
-	XbMachineOpcodeFixupItem *item;
 	XbMachinePrivate *priv = GET_PRIVATE(self);
 	guint level = 0;
 	g_autoptr(XbStack) opcodes = NULL;
-	g_autofree gchar *opcodes_sig = NULL;
 
 	g_return_val_if_fail(XB_IS_MACHINE(self), NULL);
 	g_return_val_if_fail(text != NULL, NULL);
@@ -804,35 +1024,62 @@ xb_machine_parse_full(XbMachine *self,
 	opcodes = xb_stack_new(priv->stack_size);
 	if (xb_machine_parse_text(self, opcodes, text, text_len, level, error) == G_MAXSIZE)
 		return NULL;
+	if (!xb_machine_opcodes_finish(self, opcodes, flags, error))
+		return NULL;
 
-	/* do any fixups */
-	opcodes_sig = xb_machine_get_opcodes_sig(self, opcodes);
-	if (priv->debug_flags & XB_MACHINE_DEBUG_FLAG_SHOW_OPTIMIZER)
-		g_debug("opcodes_sig=%s", opcodes_sig);
-	item = g_hash_table_lookup(priv->opcode_fixup, opcodes_sig);
-	if (item != NULL) {
-		if (!item->fixup_cb(self, opcodes, item->user_data, error))
-			return NULL;
-	}
+	/* success */
+	return g_steal_pointer(&opcodes);
+}
 
-	/* optimize */
-	if (flags & XB_MACHINE_PARSE_FLAG_OPTIMIZE) {
-		for (guint i = 0; i < 10; i++) {
-			guint oldsz = xb_stack_get_size(opcodes);
+/* private: returns a copy of @opcodes with the values in @bindings, starting at
+ * @bindings_idx, substituted as literals and optimized again */
+XbStack *
+xb_machine_opcodes_bind(XbMachine *self,
+			XbStack *opcodes,
+			XbValueBindings *bindings,
+			guint *bindings_idx,
+			GError **error)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	g_autoptr(XbStack) opcodes_new = xb_stack_new(priv->stack_size);
 
-			/* Is the stack optimal already? */
-			if (oldsz == 1)
-				break;
+	for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		XbOpcode *op_new;
+		XbOpcode op_bound;
 
-			if (!xb_machine_opcodes_optimize(self, opcodes, error))
-				return NULL;
-			if (oldsz == xb_stack_get_size(opcodes))
-				break;
+		if (!xb_stack_push(opcodes_new, &op_new, error))
+			return NULL;
+
+		/* copy the literal, and any data it owns */
+		if (!xb_opcode_is_binding(op)) {
+			*op_new = *op;
+			if (op->destroy_func != NULL)
+				op_new->ptr = g_strdup(op->ptr);
+			continue;
+		}
+		if (!xb_value_bindings_lookup_opcode(bindings, (*bindings_idx)++, &op_bound)) {
+			g_set_error_literal(error,
+					    G_IO_ERROR,
+					    G_IO_ERROR_INVALID_DATA,
+					    "opcode was not bound");
+			return NULL;
+		}
+		if (xb_opcode_get_kind(&op_bound) == XB_OPCODE_KIND_BOUND_INTEGER) {
+			xb_opcode_integer_init(op_new, xb_opcode_get_val(&op_bound));
+		} else {
+			xb_opcode_init(op_new,
+				       xb_opcode_get_kind(&op_bound) == XB_OPCODE_KIND_INDEXED_TEXT
+					   ? XB_OPCODE_KIND_INDEXED_TEXT
+					   : XB_OPCODE_KIND_TEXT,
+				       g_strdup(xb_opcode_get_str(&op_bound)),
+				       xb_opcode_get_val(&op_bound),
+				       g_free);
 		}
 	}
-
-	/* success */
-	return g_steal_pointer(&opcodes);
+	if (!xb_machine_opcodes_finish(self, opcodes_new, XB_MACHINE_PARSE_FLAG_OPTIMIZE, error))
+		return NULL;
+	return g_steal_pointer(&opcodes_new);
 }
 
 /**
@@ -873,6 +1120,7 @@ xb_machine_run_func(XbMachine *self,
 		    XbStack *stack,
 		    XbOpcode *opcode,
 		    gpointer exec_data,
+		    XbMachineMethodProfile *profile,
 		    GError **error)
 {
 	XbMachinePrivate *priv = GET_PRIVATE(self);
@@ -895,6 +1143,17 @@ xb_machine_run_func(XbMachine *self,
 			    xb_stack_get_size(stack));
 		return FALSE;
 	}
+	if (profile != NULL) {
+		gint64 start = g_get_monotonic_time();
+		gboolean ret = item->method_cb(self, stack, NULL, item->user_data, exec_data, error);
+		profile[item->idx].calls++;
+		profile[item->idx].elapsed += g_get_monotonic_time() - start;
+		if (!ret) {
+			g_prefix_error(error, "failed to call %s(): ", item->name);
+			return FALSE;
+		}
+		return TRUE;
+	}
 	if (!item->method_cb(self, stack, NULL, item->user_data, exec_data, error)) {
 		g_prefix_error(error, "failed to call %s(): ", item->name);
 		return FALSE;
@@ -902,6 +1161,23 @@ xb_machine_run_func(XbMachine *self,
 	return TRUE;
 }
 
+/* private */
+guint
+xb_machine_get_method_count(XbMachine *self)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	return priv->methods->len;
+}
+
+/* private */
+const gchar *
+xb_machine_get_method_name(XbMachine *self, guint idx)
+{
+	XbMachinePrivate *priv = GET_PRIVATE(self);
+	XbMachineMethodItem *item = g_ptr_array_index(priv->methods, idx);
+	return item->name;
+}
+
 /**
  * xb_machine_run:
  * @self: a #XbMachine
@@ -930,34 +1206,49 @@ xb_machine_run(XbMachine *self,
 	return xb_machine_run_with_bindings(self, opcodes, NULL, result, exec_data, error);
 }
 
-/**
- * xb_machine_run_with_bindings:
- * @self: a #XbMachine
- * @opcodes: a #XbStack of opcodes
- * @bindings: (nullable) (transfer none): values bound to opcodes of type
- *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
- *     the query doesn’t need any bound values
- * @result: (out): return status after running @opcodes
- * @exec_data: per-run user data that is passed to all the #XbMachineMethodFunc functions
- * @error: a #GError, or %NULL
- *
- * Runs a set of opcodes on the virtual machine, using the bound values given in
- * @bindings to substitute for bound opcodes.
- *
- * It is safe to call this function from a different thread to the one that
- * created the #XbMachine.
- *
- * Returns: a new #XbOpcode, or %NULL
- *
- * Since: 0.3.0
- **/
+/* Returns the index of the last opcode that has been run, which is @idx unless
+ * the value at the head of @stack already decides the result of an and() or
+ * or(), in which case the second argument is skipped */
+static inline guint
+xb_machine_run_jump(XbStack *opcodes, XbStack *stack, guint idx, guint *bound_opcode_idx)
+{
+	XbOpcode *op = xb_stack_peek(opcodes, idx);
+
+	while (op->jump != XB_OPCODE_JUMP_NONE) {
+		XbOpcode *head = xb_stack_peek_tail(stack);
+		gboolean val;
+
+		/* let the function fail on the wrong type */
+		if (head == NULL || !xb_opcode_cmp_val(head))
+			break;
+		val = xb_opcode_get_val(head) > 0;
+		if ((op->jump == XB_OPCODE_JUMP_IF_FALSE && val) ||
+		    (op->jump == XB_OPCODE_JUMP_IF_TRUE && !val))
+			break;
+
+		/* replace the argument with the result of the and() or or() */
+		xb_opcode_bool_init(head, val);
+
+		/* bound values are consumed in order */
+		for (guint i = idx + 1; i < op->jump_idx; i++) {
+			if (xb_opcode_is_binding(xb_stack_peek(opcodes, i)))
+				(*bound_opcode_idx)++;
+		}
+		idx = op->jump_idx;
+		op = xb_stack_peek(opcodes, idx);
+	}
+	return idx;
+}
+
+/* private: @profile is indexed by the method and can be %NULL */
 gboolean
-xb_machine_run_with_bindings(XbMachine *self,
-			     XbStack *opcodes,
-			     XbValueBindings *bindings,
-			     gboolean *result,
-			     gpointer exec_data,
-			     GError **error)
+xb_machine_run_with_profile(XbMachine *self,
+			    XbStack *opcodes,
+			    XbValueBindings *bindings,
+			    gboolean *result,
+			    gpointer exec_data,
+			    XbMachineMethodProfile *profile,
+			    GError **error)
 {
 	XbMachinePrivate *priv = GET_PRIVATE(self);
 	g_auto(XbOpcode) opcode_success = XB_OPCODE_INIT();
@@ -972,7 +1263,8 @@ xb_machine_run_with_bindings(XbMachine *self,
 
 	/* process each opcode */
 	stack = xb_stack_new_inline(priv->stack_size);
-	for (guint i = 0; i < opcodes_stack_size; i++) {
+	for (guint i = 0; i < opcodes_stack_size;
+	     i = xb_machine_run_jump(opcodes, stack, i, &bound_opcode_idx) + 1) {
 		XbOpcode *opcode = xb_stack_peek(opcodes, i);
 		XbOpcodeKind kind = xb_opcode_get_kind(opcode);
 
@@ -1010,7 +1302,7 @@ xb_machine_run_with_bindings(XbMachine *self,
 
 		/* process the stack */
 		if (kind == XB_OPCODE_KIND_FUNCTION) {
-			if (!xb_machine_run_func(self, stack, opcode, exec_data, error))
+			if (!xb_machine_run_func(self, stack, opcode, exec_data, profile, error))
 				return FALSE;
 			continue;
 		}
@@ -1067,6 +1359,38 @@ xb_machine_run_with_bindings(XbMachine *self,
 	return TRUE;
 }
 
+/**
+ * xb_machine_run_with_bindings:
+ * @self: a #XbMachine
+ * @opcodes: a #XbStack of opcodes
+ * @bindings: (nullable) (transfer none): values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any bound values
+ * @result: (out): return status after running @opcodes
+ * @exec_data: per-run user data that is passed to all the #XbMachineMethodFunc functions
+ * @error: a #GError, or %NULL
+ *
+ * Runs a set of opcodes on the virtual machine, using the bound values given in
+ * @bindings to substitute for bound opcodes.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbMachine.
+ *
+ * Returns: a new #XbOpcode, or %NULL
+ *
+ * Since: 0.3.0
+ **/
+gboolean
+xb_machine_run_with_bindings(XbMachine *self,
+			     XbStack *opcodes,
+			     XbValueBindings *bindings,
+			     gboolean *result,
+			     gpointer exec_data,
+			     GError **error)
+{
+	return xb_machine_run_with_profile(self, opcodes, bindings, result, exec_data, NULL, error);
+}
+
 /**
  * xb_machine_stack_pop:
  * @self: a #XbMachine
@@ -1340,8 +1664,9 @@ xb_machine_intern_token(XbMachine *self, const gchar *str)
 	XbMachinePrivate *priv = GET_PRIVATE(self);
 	const gchar *tmp;
 	gchar *newstr;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->opcode_tokens_mutex);
 
-	/* existing value */
+	/* existing value, as queries can be specialized from any thread */
 	tmp = g_hash_table_lookup(priv->opcode_tokens, str);
 	if (tmp != NULL)
 		return tmp;
@@ -1495,6 +1820,13 @@ xb_machine_func_eq_cb(XbMachine *self,
 					  xb_opcode_get_val(&op1) == xb_opcode_get_val(&op2),
 					  error);
 
+	/* TEXI:TEXI, both offsets into the strtab, where each string has only one
+	 * offset before the sorted tokens */
+	if (xb_opcode_cmp_indexed(&op1) && xb_opcode_cmp_indexed(&op2))
+		return xb_stack_push_bool(stack,
+					  xb_opcode_get_val(&op1) == xb_opcode_get_val(&op2),
+					  error);
+
 	/* TEXT:TEXT */
 	if (xb_opcode_cmp_str(&op1) && xb_opcode_cmp_str(&op2))
 		return xb_stack_push_bool(
@@ -1570,6 +1902,13 @@ xb_machine_func_ne_cb(XbMachine *self,
 					  error);
 	}
 
+	/* TEXI:TEXI, both offsets into the strtab, where each string has only one
+	 * offset before the sorted tokens */
+	if (xb_opcode_cmp_indexed(&op1) && xb_opcode_cmp_indexed(&op2))
+		return xb_stack_push_bool(stack,
+					  xb_opcode_get_val(&op1) != xb_opcode_get_val(&op2),
+					  error);
+
 	/* TEXT:TEXT */
 	if (xb_opcode_cmp_str(&op1) && xb_opcode_cmp_str(&op2)) {
 		return xb_stack_push_bool(
@@ -2184,6 +2523,7 @@ xb_machine_init(XbMachine *self)
 						   g_free,
 						   (GDestroyNotify)xb_machine_opcode_fixup_free);
 	priv->opcode_tokens = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_mutex_init(&priv->opcode_tokens_mutex);
 
 	/* built-in functions */
 	xb_machine_add_method(self, "and", 2, xb_machine_func_and_cb, NULL, NULL);
@@ -2228,6 +2568,7 @@ xb_machine_finalize(GObject *obj)
 	g_ptr_array_unref(priv->text_handlers);
 	g_hash_table_unref(priv->opcode_fixup);
 	g_hash_table_unref(priv->opcode_tokens);
+	g_mutex_clear(&priv->opcode_tokens_mutex);
 	G_OBJECT_CLASS(xb_machine_parent_class)->finalize(obj);
 }
 
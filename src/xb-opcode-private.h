@@ -16,6 +16,14 @@ G_BEGIN_DECLS
  * between making the _XbOpcode struct too large and search results */
 #define XB_OPCODE_TOKEN_MAX 32
 
+/* how the value left on the stack by an opcode can decide the result of the
+ * and() or or() it is the first argument of, skipping the second argument */
+typedef enum {
+	XB_OPCODE_JUMP_NONE,
+	XB_OPCODE_JUMP_IF_FALSE, /* and() */
+	XB_OPCODE_JUMP_IF_TRUE,	 /* or() */
+} XbOpcodeJump;
+
 struct _XbOpcode {
 	XbOpcodeKind kind;
 	guint32 val;
@@ -23,11 +31,13 @@ struct _XbOpcode {
 	guint8 tokens_len;
 	const gchar *tokens[XB_OPCODE_TOKEN_MAX + 1];
 	GDestroyNotify destroy_func;
+	XbOpcodeJump jump;
+	guint jump_idx; /* index of the and() or or() opcode */
 };
 
 #define XB_OPCODE_INIT()                                                                           \
 	{                                                                                          \
-		0, 0, NULL, 0, {NULL}, NULL                                                        \
+		0, 0, NULL, 0, {NULL}, NULL, XB_OPCODE_JUMP_NONE, 0                                \
 	}
 
 /**
@@ -60,6 +70,8 @@ void
 xb_opcode_bind_init(XbOpcode *opcode);
 gboolean
 xb_opcode_is_binding(XbOpcode *self);
+gboolean
+xb_opcode_cmp_indexed(XbOpcode *self);
 G_DEPRECATED_FOR(xb_value_bindings_bind_str)
 void
 xb_opcode_bind_str(XbOpcode *self, gchar *str, GDestroyNotify destroy_func);
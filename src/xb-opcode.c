@@ -227,6 +227,14 @@ xb_opcode_cmp_str(XbOpcode *self)
 	return xb_opcode_has_flag(self, XB_OPCODE_FLAG_TEXT);
 }
 
+/* private */
+gboolean
+xb_opcode_cmp_indexed(XbOpcode *self)
+{
+	return xb_opcode_get_kind(self) == XB_OPCODE_KIND_INDEXED_TEXT &&
+	       self->val != G_MAXUINT32;
+}
+
 /* private */
 gboolean
 xb_opcode_is_binding(XbOpcode *self)
@@ -341,6 +349,8 @@ xb_opcode_init(XbOpcode *opcode,
 	opcode->val = val;
 	opcode->tokens_len = 0;
 	opcode->destroy_func = destroy_func;
+	opcode->jump = XB_OPCODE_JUMP_NONE;
+	opcode->jump_idx = 0;
 }
 
 /**
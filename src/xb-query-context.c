@@ -14,7 +14,7 @@
 
 #include "config.h"
 
-#include <glib.h>
+#include <gio/gio.h>
 
 #include "xb-query.h"
 #include "xb-value-bindings.h"
@@ -29,7 +29,11 @@ typedef struct {
 	guint limit;
 	XbQueryFlags flags;
 	XbValueBindings bindings;
-	gpointer dummy[5];
+	gchar *order_key;
+	XbQueryOrderFlags order_flags;
+	GCancellable *cancellable;
+	gsize timeout; /* ms */
+	gsize max_visits;
 } RealQueryContext;
 
 G_STATIC_ASSERT(sizeof(XbQueryContext) == sizeof(RealQueryContext));
@@ -56,6 +60,11 @@ xb_query_context_init(XbQueryContext *self)
 	_self->limit = 0;
 	_self->flags = XB_QUERY_FLAG_NONE;
 	xb_value_bindings_init(&_self->bindings);
+	_self->order_key = NULL;
+	_self->order_flags = XB_QUERY_ORDER_FLAG_NONE;
+	_self->cancellable = NULL;
+	_self->timeout = 0;
+	_self->max_visits = 0;
 }
 
 /**
@@ -75,6 +84,8 @@ xb_query_context_clear(XbQueryContext *self)
 	RealQueryContext *_self = (RealQueryContext *)self;
 
 	xb_value_bindings_clear(&_self->bindings);
+	g_clear_pointer(&_self->order_key, g_free);
+	g_clear_object(&_self->cancellable);
 }
 
 /**
@@ -98,6 +109,11 @@ xb_query_context_copy(XbQueryContext *self)
 
 	_copy->limit = _self->limit;
 	_copy->flags = _self->flags;
+	_copy->order_key = g_strdup(_self->order_key);
+	_copy->order_flags = _self->order_flags;
+	g_set_object(&_copy->cancellable, _self->cancellable);
+	_copy->timeout = _self->timeout;
+	_copy->max_visits = _self->max_visits;
 
 	while (xb_value_bindings_copy_binding(&_self->bindings, i, &_copy->bindings, i))
 		i++;
@@ -221,3 +237,180 @@ xb_query_context_set_flags(XbQueryContext *self, XbQueryFlags flags)
 
 	_self->flags = flags;
 }
+
+/**
+ * xb_query_context_get_order:
+ * @self: an #XbQueryContext
+ * @flags: (out) (optional): the #XbQueryOrderFlags, or %NULL
+ *
+ * Get the key used to order the query results. See
+ * xb_query_context_set_order().
+ *
+ * Returns: (nullable): the order key, or %NULL if the results are in document order
+ * Since: 0.3.11
+ */
+const gchar *
+xb_query_context_get_order(XbQueryContext *self, XbQueryOrderFlags *flags)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_val_if_fail(self != NULL, NULL);
+
+	if (flags != NULL)
+		*flags = _self->order_flags;
+	return _self->order_key;
+}
+
+/**
+ * xb_query_context_set_order:
+ * @self: an #XbQueryContext
+ * @key: (nullable): an attribute name like `@timestamp`, `text()`, or the name
+ *     of a child element like `version`, or %NULL for document order
+ * @flags: order flags, or %XB_QUERY_ORDER_FLAG_NONE for ascending lexical order
+ *
+ * Set the key used to order the query results. Results without the key, or
+ * with a value that is not an integer when using %XB_QUERY_ORDER_FLAG_NUMERIC,
+ * are returned last, and results with equal keys stay in document order.
+ *
+ * If a limit is also set then only that number of results are kept while
+ * the query runs, so finding the newest few of many nodes is cheap.
+ *
+ * Since: 0.3.11
+ */
+void
+xb_query_context_set_order(XbQueryContext *self, const gchar *key, XbQueryOrderFlags flags)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_if_fail(self != NULL);
+
+	g_free(_self->order_key);
+	_self->order_key = g_strdup(key);
+	_self->order_flags = flags;
+}
+
+/**
+ * xb_query_context_get_cancellable:
+ * @self: an #XbQueryContext
+ *
+ * Get the #GCancellable used to stop the query. See
+ * xb_query_context_set_cancellable().
+ *
+ * Returns: (transfer none) (nullable): a #GCancellable, or %NULL if unset
+ * Since: 0.3.11
+ */
+GCancellable *
+xb_query_context_get_cancellable(XbQueryContext *self)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_val_if_fail(self != NULL, NULL);
+
+	return _self->cancellable;
+}
+
+/**
+ * xb_query_context_set_cancellable:
+ * @self: an #XbQueryContext
+ * @cancellable: (nullable): a #GCancellable, or %NULL
+ *
+ * Set a #GCancellable which can be used from another thread to stop the query,
+ * which then fails with %G_IO_ERROR_CANCELLED.
+ *
+ * Since: 0.3.11
+ */
+void
+xb_query_context_set_cancellable(XbQueryContext *self, GCancellable *cancellable)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_if_fail(self != NULL);
+	g_return_if_fail(cancellable == NULL || G_IS_CANCELLABLE(cancellable));
+
+	g_set_object(&_self->cancellable, cancellable);
+}
+
+/**
+ * xb_query_context_get_timeout:
+ * @self: an #XbQueryContext
+ *
+ * Get the time the query is allowed to run for. See
+ * xb_query_context_set_timeout().
+ *
+ * Returns: timeout in milliseconds, or `0` if unlimited
+ * Since: 0.3.11
+ */
+guint
+xb_query_context_get_timeout(XbQueryContext *self)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_val_if_fail(self != NULL, 0);
+
+	return _self->timeout;
+}
+
+/**
+ * xb_query_context_set_timeout:
+ * @self: an #XbQueryContext
+ * @timeout: time in milliseconds, or `0` for unlimited
+ *
+ * Set the deadline for the query, measured from when it starts to run. Once
+ * the deadline has passed the query fails with %G_IO_ERROR_TIMED_OUT, unless
+ * %XB_QUERY_FLAG_ALLOW_PARTIAL is set.
+ *
+ * The deadline is only checked every few hundred nodes, so the query may run
+ * for slightly longer than @timeout.
+ *
+ * Since: 0.3.11
+ */
+void
+xb_query_context_set_timeout(XbQueryContext *self, guint timeout)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_if_fail(self != NULL);
+
+	_self->timeout = timeout;
+}
+
+/**
+ * xb_query_context_get_max_visits:
+ * @self: an #XbQueryContext
+ *
+ * Get the number of nodes the query is allowed to visit. See
+ * xb_query_context_set_max_visits().
+ *
+ * Returns: number of nodes, or `0` if unlimited
+ * Since: 0.3.11
+ */
+guint
+xb_query_context_get_max_visits(XbQueryContext *self)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_val_if_fail(self != NULL, 0);
+
+	return _self->max_visits;
+}
+
+/**
+ * xb_query_context_set_max_visits:
+ * @self: an #XbQueryContext
+ * @max_visits: number of nodes, or `0` for unlimited
+ *
+ * Set the maximum number of nodes the query can check against its predicates.
+ * Once this is exceeded the query fails with %G_IO_ERROR_TIMED_OUT, unless
+ * %XB_QUERY_FLAG_ALLOW_PARTIAL is set.
+ *
+ * Since: 0.3.11
+ */
+void
+xb_query_context_set_max_visits(XbQueryContext *self, guint max_visits)
+{
+	RealQueryContext *_self = (RealQueryContext *)self;
+
+	g_return_if_fail(self != NULL);
+
+	_self->max_visits = max_visits;
+}
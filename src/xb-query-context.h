@@ -10,7 +10,7 @@
 
 #pragma once
 
-#include <glib.h>
+#include <gio/gio.h>
 
 #include "xb-query.h"
 #include "xb-value-bindings.h"
@@ -33,6 +33,24 @@ typedef struct {
 	gpointer dummy3[5];
 } XbQueryContext;
 
+/**
+ * XbQueryOrderFlags:
+ * @XB_QUERY_ORDER_FLAG_NONE:		Ascending lexical order
+ * @XB_QUERY_ORDER_FLAG_DESCENDING:	Descending order
+ * @XB_QUERY_ORDER_FLAG_NUMERIC:		Compare the values as integers
+ *
+ * The flags used when ordering query results.
+ *
+ * Since: 0.3.11
+ **/
+typedef enum {
+	XB_QUERY_ORDER_FLAG_NONE = 0,		 /* Since: 0.3.11 */
+	XB_QUERY_ORDER_FLAG_DESCENDING = 1 << 0, /* Since: 0.3.11 */
+	XB_QUERY_ORDER_FLAG_NUMERIC = 1 << 1,	 /* Since: 0.3.11 */
+	/*< private >*/
+	XB_QUERY_ORDER_FLAG_LAST
+} XbQueryOrderFlags;
+
 GType
 xb_query_context_get_type(void);
 
@@ -83,4 +101,22 @@ xb_query_context_get_flags(XbQueryContext *self);
 void
 xb_query_context_set_flags(XbQueryContext *self, XbQueryFlags flags);
 
+const gchar *
+xb_query_context_get_order(XbQueryContext *self, XbQueryOrderFlags *flags);
+void
+xb_query_context_set_order(XbQueryContext *self, const gchar *key, XbQueryOrderFlags flags);
+
+GCancellable *
+xb_query_context_get_cancellable(XbQueryContext *self);
+void
+xb_query_context_set_cancellable(XbQueryContext *self, GCancellable *cancellable);
+guint
+xb_query_context_get_timeout(XbQueryContext *self);
+void
+xb_query_context_set_timeout(XbQueryContext *self, guint timeout);
+guint
+xb_query_context_get_max_visits(XbQueryContext *self);
+void
+xb_query_context_set_max_visits(XbQueryContext *self, guint max_visits);
+
 G_END_DECLS
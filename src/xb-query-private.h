@@ -9,6 +9,7 @@
 #include <glib-object.h>
 
 #include "xb-query.h"
+#include "xb-value-bindings.h"
 
 G_BEGIN_DECLS
 
@@ -19,16 +20,37 @@ typedef enum {
 	XB_SILO_QUERY_KIND_LAST
 } XbSiloQueryKind;
 
+typedef enum {
+	XB_SILO_QUERY_AXIS_CHILD,
+	XB_SILO_QUERY_AXIS_DESCENDANT,
+	XB_SILO_QUERY_AXIS_LAST
+} XbSiloQueryAxis;
+
 typedef struct {
 	gchar *element;
 	guint32 element_idx;
 	GPtrArray *predicates; /* of XbStack */
 	XbSiloQueryKind kind;
+	XbSiloQueryAxis axis;
 } XbQuerySection;
 
 GPtrArray *
 xb_query_get_sections(XbQuery *self);
 gchar *
+xb_query_section_to_string(XbQuerySection *sect);
+gchar *
 xb_query_to_string(XbQuery *self);
+gboolean
+xb_query_get_never_matches(XbQuery *self);
+gboolean
+xb_query_get_may_repeat(XbQuery *self);
+gboolean
+xb_query_get_projection_text(XbQuery *self);
+const gchar *
+xb_query_get_projection_attr(XbQuery *self);
+gboolean
+xb_query_get_binding_in_strtab(XbQuery *self, guint idx);
+XbQuery *
+xb_query_get_specialized(XbQuery *self, XbSilo *silo, XbValueBindings *bindings);
 
 G_END_DECLS
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 The libxmlb authors
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include "xb-machine-private.h"
+#include "xb-query-profile.h"
+#include "xb-query.h"
+
+G_BEGIN_DECLS
+
+typedef struct {
+	guint64 evaluations;
+	guint64 matches;
+} XbQueryProfilePredicate;
+
+typedef struct {
+	guint64 visited;
+	guint64 matched;
+	gint64 elapsed;			     /* µs, including the later sections */
+	XbQueryProfilePredicate *predicates; /* (array-length n_predicates) */
+	guint n_predicates;
+} XbQueryProfileSection;
+
+XbQueryProfile *
+xb_query_profile_new(XbQuery *query, XbMachine *machine);
+void
+xb_query_profile_set_query(XbQueryProfile *self, XbQuery *query);
+XbQueryProfileSection *
+xb_query_profile_get_section(XbQueryProfile *self, guint idx);
+XbMachineMethodProfile *
+xb_query_profile_get_methods(XbQueryProfile *self);
+void
+xb_query_profile_add_bindings_copied(XbQueryProfile *self, guint cnt);
+void
+xb_query_profile_add_node_cache_hit(XbQueryProfile *self);
+void
+xb_query_profile_set_results(XbQueryProfile *self, guint results);
+void
+xb_query_profile_set_elapsed(XbQueryProfile *self, gint64 elapsed);
+
+G_END_DECLS
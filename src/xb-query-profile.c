@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) 2026 The libxmlb authors
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#define G_LOG_DOMAIN "XbSilo"
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "xb-query-private.h"
+#include "xb-query-profile-private.h"
+
+typedef struct {
+	gchar *xpath;
+	GPtrArray *section_strs;	 /* of utf8 */
+	XbQueryProfileSection *sections; /* (array-length n_sections) */
+	guint n_sections;
+	XbMachine *machine;
+	XbMachineMethodProfile *methods; /* (array-length n_methods) */
+	guint n_methods;
+	guint64 bindings_copied;
+	guint64 node_cache_hits;
+	guint results;
+	gint64 elapsed; /* µs */
+} XbQueryProfilePrivate;
+
+G_DEFINE_TYPE_WITH_PRIVATE(XbQueryProfile, xb_query_profile, G_TYPE_OBJECT)
+#define GET_PRIVATE(o) (xb_query_profile_get_instance_private(o))
+
+/* private */
+XbQueryProfileSection *
+xb_query_profile_get_section(XbQueryProfile *self, guint idx)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	if (idx >= priv->n_sections)
+		return NULL;
+	return &priv->sections[idx];
+}
+
+/* private */
+XbMachineMethodProfile *
+xb_query_profile_get_methods(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	return priv->methods;
+}
+
+/* private */
+void
+xb_query_profile_add_bindings_copied(XbQueryProfile *self, guint cnt)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	priv->bindings_copied += cnt;
+}
+
+/* private */
+void
+xb_query_profile_add_node_cache_hit(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	priv->node_cache_hits++;
+}
+
+/* private */
+void
+xb_query_profile_set_results(XbQueryProfile *self, guint results)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	priv->results = results;
+}
+
+/* private */
+void
+xb_query_profile_set_elapsed(XbQueryProfile *self, gint64 elapsed)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	priv->elapsed = elapsed;
+}
+
+/**
+ * xb_query_profile_get_elapsed:
+ * @self: a #XbQueryProfile
+ *
+ * Gets the time taken to run the query.
+ *
+ * Returns: time in seconds
+ *
+ * Since: 0.3.11
+ **/
+gdouble
+xb_query_profile_get_elapsed(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0.f);
+	return (gdouble)priv->elapsed / G_USEC_PER_SEC;
+}
+
+/**
+ * xb_query_profile_get_results:
+ * @self: a #XbQueryProfile
+ *
+ * Gets the number of results returned by the query.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint
+xb_query_profile_get_results(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	return priv->results;
+}
+
+/**
+ * xb_query_profile_get_bindings_copied:
+ * @self: a #XbQueryProfile
+ *
+ * Gets the number of bound values copied for each predicate that was run.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_bindings_copied(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	return priv->bindings_copied;
+}
+
+/**
+ * xb_query_profile_get_node_cache_hits:
+ * @self: a #XbQueryProfile
+ *
+ * Gets the number of results that were already in the #XbNode cache.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_node_cache_hits(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	return priv->node_cache_hits;
+}
+
+/**
+ * xb_query_profile_get_section_count:
+ * @self: a #XbQueryProfile
+ *
+ * Gets the number of sections in the query, e.g. `components/component` has 2.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint
+xb_query_profile_get_section_count(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	return priv->n_sections;
+}
+
+/**
+ * xb_query_profile_get_section_visited:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ *
+ * Gets the number of nodes that were compared against the section.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_section_visited(XbQueryProfile *self, guint idx)
+{
+	XbQueryProfileSection *section;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	section = xb_query_profile_get_section(self, idx);
+	return section != NULL ? section->visited : 0;
+}
+
+/**
+ * xb_query_profile_get_section_matched:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ *
+ * Gets the number of nodes that matched the element name and all the
+ * predicates of the section.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_section_matched(XbQueryProfile *self, guint idx)
+{
+	XbQueryProfileSection *section;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	section = xb_query_profile_get_section(self, idx);
+	return section != NULL ? section->matched : 0;
+}
+
+/**
+ * xb_query_profile_get_section_elapsed:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ *
+ * Gets the time taken by the section, which includes the time taken by all the
+ * sections after it.
+ *
+ * Returns: time in seconds
+ *
+ * Since: 0.3.11
+ **/
+gdouble
+xb_query_profile_get_section_elapsed(XbQueryProfile *self, guint idx)
+{
+	XbQueryProfileSection *section;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0.f);
+	section = xb_query_profile_get_section(self, idx);
+	return section != NULL ? (gdouble)section->elapsed / G_USEC_PER_SEC : 0.f;
+}
+
+/**
+ * xb_query_profile_get_predicate_count:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ *
+ * Gets the number of predicates in the section.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint
+xb_query_profile_get_predicate_count(XbQueryProfile *self, guint idx)
+{
+	XbQueryProfileSection *section;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	section = xb_query_profile_get_section(self, idx);
+	return section != NULL ? section->n_predicates : 0;
+}
+
+static XbQueryProfilePredicate *
+xb_query_profile_get_predicate(XbQueryProfile *self, guint idx, guint predicate_idx)
+{
+	XbQueryProfileSection *section = xb_query_profile_get_section(self, idx);
+	if (section == NULL || predicate_idx >= section->n_predicates)
+		return NULL;
+	return &section->predicates[predicate_idx];
+}
+
+/**
+ * xb_query_profile_get_predicate_evaluations:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ * @predicate_idx: a predicate index
+ *
+ * Gets the number of times the predicate was run. Predicates are only run if
+ * the ones before them in the section matched.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_predicate_evaluations(XbQueryProfile *self, guint idx, guint predicate_idx)
+{
+	XbQueryProfilePredicate *predicate;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	predicate = xb_query_profile_get_predicate(self, idx, predicate_idx);
+	return predicate != NULL ? predicate->evaluations : 0;
+}
+
+/**
+ * xb_query_profile_get_predicate_matches:
+ * @self: a #XbQueryProfile
+ * @idx: a section index
+ * @predicate_idx: a predicate index
+ *
+ * Gets the number of times the predicate was true.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_predicate_matches(XbQueryProfile *self, guint idx, guint predicate_idx)
+{
+	XbQueryProfilePredicate *predicate;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	predicate = xb_query_profile_get_predicate(self, idx, predicate_idx);
+	return predicate != NULL ? predicate->matches : 0;
+}
+
+static XbMachineMethodProfile *
+xb_query_profile_get_method(XbQueryProfile *self, const gchar *name)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	for (guint i = 0; i < priv->n_methods; i++) {
+		if (g_strcmp0(xb_machine_get_method_name(priv->machine, i), name) == 0)
+			return &priv->methods[i];
+	}
+	return NULL;
+}
+
+/**
+ * xb_query_profile_get_method_calls:
+ * @self: a #XbQueryProfile
+ * @name: a method name, e.g. `contains`
+ *
+ * Gets the number of times the #XbMachine method was called.
+ *
+ * Returns: integer
+ *
+ * Since: 0.3.11
+ **/
+guint64
+xb_query_profile_get_method_calls(XbQueryProfile *self, const gchar *name)
+{
+	XbMachineMethodProfile *method;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0);
+	g_return_val_if_fail(name != NULL, 0);
+	method = xb_query_profile_get_method(self, name);
+	return method != NULL ? method->calls : 0;
+}
+
+/**
+ * xb_query_profile_get_method_elapsed:
+ * @self: a #XbQueryProfile
+ * @name: a method name, e.g. `contains`
+ *
+ * Gets the total time taken by the #XbMachine method.
+ *
+ * Returns: time in seconds
+ *
+ * Since: 0.3.11
+ **/
+gdouble
+xb_query_profile_get_method_elapsed(XbQueryProfile *self, const gchar *name)
+{
+	XbMachineMethodProfile *method;
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), 0.f);
+	g_return_val_if_fail(name != NULL, 0.f);
+	method = xb_query_profile_get_method(self, name);
+	return method != NULL ? (gdouble)method->elapsed / G_USEC_PER_SEC : 0.f;
+}
+
+/**
+ * xb_query_profile_to_string:
+ * @self: a #XbQueryProfile
+ *
+ * Gets a multiline string showing where the time was spent running the query.
+ *
+ * Returns: string
+ *
+ * Since: 0.3.11
+ **/
+gchar *
+xb_query_profile_to_string(XbQueryProfile *self)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	GString *str;
+
+	g_return_val_if_fail(XB_IS_QUERY_PROFILE(self), NULL);
+
+	str = g_string_new(NULL);
+	g_string_append_printf(str,
+			       "query `%s` -> %u results in %.2fms\n",
+			       priv->xpath,
+			       priv->results,
+			       (gdouble)priv->elapsed / 1000);
+	for (guint i = 0; i < priv->n_sections; i++) {
+		XbQueryProfileSection *section = &priv->sections[i];
+		g_string_append_printf(str,
+				       "  section %u `%s`: %.2fms, visited %" G_GUINT64_FORMAT
+				       ", matched %" G_GUINT64_FORMAT "\n",
+				       i,
+				       (const gchar *)g_ptr_array_index(priv->section_strs, i),
+				       (gdouble)section->elapsed / 1000,
+				       section->visited,
+				       section->matched);
+		for (guint j = 0; j < section->n_predicates; j++) {
+			XbQueryProfilePredicate *predicate = &section->predicates[j];
+			g_string_append_printf(str,
+					       "    predicate %u: evaluated %" G_GUINT64_FORMAT
+					       ", true %.1f%%\n",
+					       j,
+					       predicate->evaluations,
+					       predicate->evaluations > 0
+						   ? 100.f * predicate->matches /
+							 predicate->evaluations
+						   : 0.f);
+		}
+	}
+	for (guint i = 0; i < priv->n_methods; i++) {
+		XbMachineMethodProfile *method = &priv->methods[i];
+		if (method->calls == 0)
+			continue;
+		g_string_append_printf(str,
+				       "  method %s(): %.2fms, called %" G_GUINT64_FORMAT "\n",
+				       xb_machine_get_method_name(priv->machine, i),
+				       (gdouble)method->elapsed / 1000,
+				       method->calls);
+	}
+	g_string_append_printf(str,
+			       "  bindings copied: %" G_GUINT64_FORMAT "\n",
+			       priv->bindings_copied);
+	g_string_append_printf(str,
+			       "  node cache hits: %" G_GUINT64_FORMAT "\n",
+			       priv->node_cache_hits);
+	return g_string_free(str, FALSE);
+}
+
+static void
+xb_query_profile_init(XbQueryProfile *self)
+{
+}
+
+static void
+xb_query_profile_finalize(GObject *obj)
+{
+	XbQueryProfile *self = XB_QUERY_PROFILE(obj);
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	for (guint i = 0; i < priv->n_sections; i++)
+		g_free(priv->sections[i].predicates);
+	g_free(priv->sections);
+	g_free(priv->methods);
+	g_ptr_array_unref(priv->section_strs);
+	g_object_unref(priv->machine);
+	g_free(priv->xpath);
+	G_OBJECT_CLASS(xb_query_profile_parent_class)->finalize(obj);
+}
+
+static void
+xb_query_profile_class_init(XbQueryProfileClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = xb_query_profile_finalize;
+}
+
+/* private: sets the sections and predicates to record, which is only
+ * possible before the query is run */
+void
+xb_query_profile_set_query(XbQueryProfile *self, XbQuery *query)
+{
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+	GPtrArray *sections = xb_query_get_sections(query);
+
+	for (guint i = 0; i < priv->n_sections; i++)
+		g_free(priv->sections[i].predicates);
+	g_free(priv->sections);
+	g_free(priv->xpath);
+	if (priv->section_strs != NULL)
+		g_ptr_array_unref(priv->section_strs);
+
+	priv->xpath = xb_query_to_string(query);
+	priv->section_strs = g_ptr_array_new_with_free_func(g_free);
+	priv->n_sections = sections->len;
+	priv->sections = g_new0(XbQueryProfileSection, sections->len);
+	for (guint i = 0; i < sections->len; i++) {
+		XbQuerySection *section = g_ptr_array_index(sections, i);
+		g_ptr_array_add(priv->section_strs, xb_query_section_to_string(section));
+		if (section->predicates == NULL)
+			continue;
+		priv->sections[i].n_predicates = section->predicates->len;
+		priv->sections[i].predicates =
+		    g_new0(XbQueryProfilePredicate, section->predicates->len);
+	}
+}
+
+/* private */
+XbQueryProfile *
+xb_query_profile_new(XbQuery *query, XbMachine *machine)
+{
+	XbQueryProfile *self = g_object_new(XB_TYPE_QUERY_PROFILE, NULL);
+	XbQueryProfilePrivate *priv = GET_PRIVATE(self);
+
+	xb_query_profile_set_query(self, query);
+	priv->machine = g_object_ref(machine);
+	priv->n_methods = xb_machine_get_method_count(machine);
+	priv->methods = g_new0(XbMachineMethodProfile, priv->n_methods);
+	return self;
+}
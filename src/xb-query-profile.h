@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The libxmlb authors
+ *
+ * SPDX-License-Identifier: LGPL-2.1+
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define XB_TYPE_QUERY_PROFILE (xb_query_profile_get_type())
+G_DECLARE_DERIVABLE_TYPE(XbQueryProfile, xb_query_profile, XB, QUERY_PROFILE, GObject)
+
+struct _XbQueryProfileClass {
+	GObjectClass parent_class;
+	/*< private >*/
+	void (*_xb_reserved1)(void);
+	void (*_xb_reserved2)(void);
+	void (*_xb_reserved3)(void);
+	void (*_xb_reserved4)(void);
+	void (*_xb_reserved5)(void);
+	void (*_xb_reserved6)(void);
+	void (*_xb_reserved7)(void);
+};
+
+gchar *
+xb_query_profile_to_string(XbQueryProfile *self);
+gdouble
+xb_query_profile_get_elapsed(XbQueryProfile *self);
+guint
+xb_query_profile_get_results(XbQueryProfile *self);
+guint64
+xb_query_profile_get_bindings_copied(XbQueryProfile *self);
+guint64
+xb_query_profile_get_node_cache_hits(XbQueryProfile *self);
+
+guint
+xb_query_profile_get_section_count(XbQueryProfile *self);
+guint64
+xb_query_profile_get_section_visited(XbQueryProfile *self, guint idx);
+guint64
+xb_query_profile_get_section_matched(XbQueryProfile *self, guint idx);
+gdouble
+xb_query_profile_get_section_elapsed(XbQueryProfile *self, guint idx);
+
+guint
+xb_query_profile_get_predicate_count(XbQueryProfile *self, guint idx);
+guint64
+xb_query_profile_get_predicate_evaluations(XbQueryProfile *self, guint idx, guint predicate_idx);
+guint64
+xb_query_profile_get_predicate_matches(XbQueryProfile *self, guint idx, guint predicate_idx);
+
+guint64
+xb_query_profile_get_method_calls(XbQueryProfile *self, const gchar *name);
+gdouble
+xb_query_profile_get_method_elapsed(XbQueryProfile *self, const gchar *name);
+
+G_END_DECLS
@@ -9,8 +9,9 @@
 #include "config.h"
 
 #include <gio/gio.h>
+#include <string.h>
 
-#include "xb-machine.h"
+#include "xb-machine-private.h"
 #include "xb-opcode-private.h"
 #include "xb-query-private.h"
 #include "xb-silo-private.h"
@@ -21,13 +22,23 @@ typedef struct {
 	XbQueryFlags flags;
 	gchar *xpath;
 	guint limit;
+	gboolean never_matches;
+	gboolean projection_text;
+	gchar *projection_attr;
+	guint32 strtab_bindings; /* bitmask of bound values compared against the strtab */
+	gboolean specialize;	 /* if the bound values should be substituted */
+	GHashTable *specialized; /* (nullable) (mutex specialized_mutex): key to XbQuery */
+	GMutex specialized_mutex;
 } XbQueryPrivate;
 
+#define XB_QUERY_SPECIALIZED_MAX 16
+
 G_DEFINE_TYPE_WITH_PRIVATE(XbQuery, xb_query, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (xb_query_get_instance_private(o))
 
 typedef struct {
 	XbSilo *silo;
+	guint bound_opcode_idx;
 } XbQueryParseContext;
 
 /**
@@ -66,7 +77,8 @@ xb_query_get_xpath(XbQuery *self)
 	return priv->xpath;
 }
 
-static gchar *
+/* private */
+gchar *
 xb_query_section_to_string(XbQuerySection *sect)
 {
 	GString *str = g_string_new(NULL);
@@ -106,13 +118,69 @@ xb_query_to_string(XbQuery *self)
 	for (guint i = 0; i < priv->sections->len; i++) {
 		XbQuerySection *sect = g_ptr_array_index(priv->sections, i);
 		g_autofree gchar *tmp = xb_query_section_to_string(sect);
-		g_string_append(str, tmp);
-		if (i != priv->sections->len - 1)
+		if (i > 0)
 			g_string_append(str, "/");
+		if (sect->axis == XB_SILO_QUERY_AXIS_DESCENDANT)
+			g_string_append(str, i == 0 ? "//" : "/");
+		g_string_append(str, tmp);
 	}
+	if (priv->projection_text)
+		g_string_append(str, "/text()");
+	if (priv->projection_attr != NULL)
+		g_string_append_printf(str, "/@%s", priv->projection_attr);
 	return g_string_free(str, FALSE);
 }
 
+/* private */
+gboolean
+xb_query_get_never_matches(XbQuery *self)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	return priv->never_matches;
+}
+
+/* private: only a parent section, or the descendants of more than one node,
+ * can find the same node more than once */
+gboolean
+xb_query_get_may_repeat(XbQuery *self)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	for (guint i = 0; i < priv->sections->len; i++) {
+		XbQuerySection *section = g_ptr_array_index(priv->sections, i);
+		if (section->kind == XB_SILO_QUERY_KIND_PARENT)
+			return TRUE;
+		if (i > 0 && section->axis == XB_SILO_QUERY_AXIS_DESCENDANT)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* private: if the XPath ended with `/text()` */
+gboolean
+xb_query_get_projection_text(XbQuery *self)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	return priv->projection_text;
+}
+
+/* private: if the XPath ended with `/@attr` */
+const gchar *
+xb_query_get_projection_attr(XbQuery *self)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	return priv->projection_attr;
+}
+
+/* private */
+gboolean
+xb_query_get_binding_in_strtab(XbQuery *self, guint idx)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	if (idx >= 32)
+		return FALSE;
+	return (priv->strtab_bindings & (1u << idx)) > 0;
+}
+
 /**
  * xb_query_get_limit:
  * @self: a #XbQuery
@@ -328,6 +396,123 @@ xb_query_repair_opcode_texi(XbQuery *self,
 	return TRUE;
 }
 
+static gboolean
+xb_query_opcode_is_func(XbOpcode *op, const gchar *func_name)
+{
+	return xb_opcode_get_kind(op) == XB_OPCODE_KIND_FUNCTION &&
+	       g_strcmp0(xb_opcode_get_str(op), func_name) == 0;
+}
+
+/* the opcodes @start to @end only push a string that is stored in the strtab,
+ * i.e. `text()`, `tail()` or `attr('foo')` */
+static gboolean
+xb_query_opcodes_are_strtab_value(XbStack *opcodes, guint start, guint end)
+{
+	XbOpcode *op;
+
+	if (end - start == 1) {
+		op = xb_stack_peek(opcodes, start);
+		return xb_query_opcode_is_func(op, "text") || xb_query_opcode_is_func(op, "tail");
+	}
+	if (end - start == 2) {
+		op = xb_stack_peek(opcodes, start);
+		if (!xb_opcode_cmp_str(op) || xb_opcode_is_binding(op))
+			return FALSE;
+		return xb_query_opcode_is_func(xb_stack_peek(opcodes, start + 1), "attr");
+	}
+	return FALSE;
+}
+
+/* Returns the index of the literal or bound opcode that has to be equal to a
+ * string from the strtab for the predicate to match, or G_MAXUINT if the
+ * predicate is not of the form `text()='foo'`, `@foo=?` or similar. */
+static guint
+xb_query_predicate_get_strtab_literal(XbStack *opcodes)
+{
+	guint sz = xb_stack_get_size(opcodes);
+
+	if (sz < 3 || sz > 4)
+		return G_MAXUINT;
+	if (!xb_query_opcode_is_func(xb_stack_peek(opcodes, sz - 1), "eq"))
+		return G_MAXUINT;
+
+	/* `text()='foo'` */
+	if (xb_query_opcodes_are_strtab_value(opcodes, 0, sz - 2))
+		return sz - 2;
+
+	/* `'foo'=text()` */
+	if (xb_query_opcodes_are_strtab_value(opcodes, 1, sz - 1))
+		return 0;
+
+	return G_MAXUINT;
+}
+
+/* Takes ownership of @opcodes, and adds them to @section. */
+static gboolean
+xb_query_add_predicate(XbQuery *self,
+		       XbQueryParseContext *context,
+		       XbQuerySection *section,
+		       XbStack *opcodes_owned,
+		       GError **error)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	guint literal_idx;
+	g_autoptr(XbStack) opcodes = opcodes_owned;
+
+	/* repair or convert the indexed strings */
+	if (priv->flags & XB_QUERY_FLAG_USE_INDEXES) {
+		for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+			XbOpcode *op = xb_stack_peek(opcodes, i);
+			if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_INDEXED_TEXT)
+				continue;
+			if (!xb_query_repair_opcode_texi(self, context, op, error))
+				return FALSE;
+		}
+	} else {
+		for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+			XbOpcode *op = xb_stack_peek(opcodes, i);
+			if (xb_opcode_get_kind(op) == XB_OPCODE_KIND_INDEXED_TEXT)
+				xb_opcode_set_kind(op, XB_OPCODE_KIND_TEXT);
+		}
+	}
+
+	/* intern the remaining literals so they can be compared using the
+	 * strtab offset rather than the string contents */
+	for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		guint32 val;
+		if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_TEXT ||
+		    xb_opcode_has_flag(op, XB_OPCODE_FLAG_TOKENIZED) || xb_opcode_get_str(op) == NULL)
+			continue;
+		val = xb_silo_strtab_index_lookup(context->silo, xb_opcode_get_str(op));
+		if (val == XB_SILO_UNSET)
+			continue;
+		xb_opcode_set_kind(op, XB_OPCODE_KIND_INDEXED_TEXT);
+		xb_opcode_set_val(op, val);
+	}
+
+	/* if the value has to be in the strtab and is not, nothing can match */
+	literal_idx = xb_query_predicate_get_strtab_literal(opcodes);
+	for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		if (xb_opcode_is_binding(op)) {
+			if (i == literal_idx && context->bound_opcode_idx < 32)
+				priv->strtab_bindings |= 1u << context->bound_opcode_idx;
+			context->bound_opcode_idx++;
+			continue;
+		}
+		if (i == literal_idx && xb_opcode_get_kind(op) == XB_OPCODE_KIND_TEXT)
+			priv->never_matches = TRUE;
+	}
+
+	/* create array if it does not exist */
+	if (section->predicates == NULL)
+		section->predicates =
+		    g_ptr_array_new_with_free_func((GDestroyNotify)xb_stack_unref);
+	g_ptr_array_add(section->predicates, g_steal_pointer(&opcodes));
+	return TRUE;
+}
+
 /* Returns an error if the XPath is invalid. */
 static gboolean
 xb_query_parse_predicate(XbQuery *self,
@@ -339,7 +524,7 @@ xb_query_parse_predicate(XbQuery *self,
 {
 	XbQueryPrivate *priv = GET_PRIVATE(self);
 	XbMachineParseFlags machine_flags = XB_MACHINE_PARSE_FLAG_NONE;
-	g_autoptr(XbStack) opcodes = NULL;
+	XbStack *opcodes;
 
 	/* set flags */
 	if (priv->flags & XB_QUERY_FLAG_OPTIMIZE)
@@ -353,30 +538,97 @@ xb_query_parse_predicate(XbQuery *self,
 					error);
 	if (opcodes == NULL)
 		return FALSE;
+	return xb_query_add_predicate(self, context, section, opcodes, error);
+}
 
-	/* repair or convert the indexed strings */
-	if (priv->flags & XB_QUERY_FLAG_USE_INDEXES) {
-		for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
-			XbOpcode *op = xb_stack_peek(opcodes, i);
-			if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_INDEXED_TEXT)
-				continue;
-			if (!xb_query_repair_opcode_texi(self, context, op, error))
-				return FALSE;
+/* Returns the fraction of the elements of @section expected to match the
+ * predicate, using the number of times the value is found in the silo, or 1.0
+ * if the predicate is not of the form `text()='foo'` or `@foo='bar'`. */
+static gdouble
+xb_query_predicate_get_selectivity(XbSilo *silo,
+				   XbQuerySection *section,
+				   XbStack *opcodes,
+				   guint total)
+{
+	guint sz = xb_stack_get_size(opcodes);
+	guint literal_idx = xb_query_predicate_get_strtab_literal(opcodes);
+	guint start;
+	guint end;
+	const gchar *attr = NULL;
+	XbOpcode *op;
+
+	if (literal_idx == G_MAXUINT)
+		return 1.f;
+	op = xb_stack_peek(opcodes, literal_idx);
+	if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_INDEXED_TEXT)
+		return 1.f;
+
+	/* the value is on the other side of the `=` */
+	start = literal_idx == 0 ? 1 : 0;
+	end = literal_idx == 0 ? sz - 1 : sz - 2;
+	if (end - start == 2) {
+		attr = xb_opcode_get_str(xb_stack_peek(opcodes, start));
+		if (attr == NULL)
+			return 1.f;
+	} else if (!xb_query_opcode_is_func(xb_stack_peek(opcodes, start), "text")) {
+		return 1.f;
+	}
+	return (gdouble)xb_silo_get_value_count(silo,
+						section->element_idx,
+						attr,
+						xb_opcode_get_val(op)) /
+	       total;
+}
+
+/* Orders the predicates of @section so the ones expected to match the fewest
+ * elements are run first. Sections with bound values are skipped, as the
+ * values are consumed in the order of the predicates. */
+static void
+xb_query_plan_section(XbQuery *self, XbQueryParseContext *context, XbQuerySection *section)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	g_autofree gdouble *selectivity = NULL;
+	guint total;
+
+	if ((priv->flags & XB_QUERY_FLAG_OPTIMIZE) == 0)
+		return;
+	if (section->predicates == NULL || section->predicates->len < 2)
+		return;
+	for (guint i = 0; i < section->predicates->len; i++) {
+		XbStack *opcodes = g_ptr_array_index(section->predicates, i);
+		for (guint j = 0; j < xb_stack_get_size(opcodes); j++) {
+			if (xb_opcode_is_binding(xb_stack_peek(opcodes, j)))
+				return;
 		}
-	} else {
-		for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
-			XbOpcode *op = xb_stack_peek(opcodes, i);
-			if (xb_opcode_get_kind(op) == XB_OPCODE_KIND_INDEXED_TEXT)
-				xb_opcode_set_kind(op, XB_OPCODE_KIND_TEXT);
+	}
+	total = xb_silo_get_element_count(context->silo, section->element_idx);
+	if (total == 0)
+		return;
+
+	selectivity = g_new0(gdouble, section->predicates->len);
+	for (guint i = 0; i < section->predicates->len; i++) {
+		XbStack *opcodes = g_ptr_array_index(section->predicates, i);
+		selectivity[i] =
+		    xb_query_predicate_get_selectivity(context->silo, section, opcodes, total);
+
+		/* the value is in the silo, but never for this element */
+		if (selectivity[i] == 0.f) {
+			priv->never_matches = TRUE;
+			return;
 		}
 	}
 
-	/* create array if it does not exist */
-	if (section->predicates == NULL)
-		section->predicates =
-		    g_ptr_array_new_with_free_func((GDestroyNotify)xb_stack_unref);
-	g_ptr_array_add(section->predicates, g_steal_pointer(&opcodes));
-	return TRUE;
+	/* insertion sort, so predicates with the same estimate keep their order */
+	for (guint i = 1; i < section->predicates->len; i++) {
+		for (guint j = i; j > 0 && selectivity[j - 1] > selectivity[j]; j--) {
+			gdouble tmp = selectivity[j - 1];
+			gpointer op_tmp = section->predicates->pdata[j - 1];
+			selectivity[j - 1] = selectivity[j];
+			selectivity[j] = tmp;
+			section->predicates->pdata[j - 1] = section->predicates->pdata[j];
+			section->predicates->pdata[j] = op_tmp;
+		}
+	}
 }
 
 /* Returns an error if the XPath is invalid. */
@@ -384,13 +636,28 @@ static XbQuerySection *
 xb_query_parse_section(XbQuery *self,
 		       XbQueryParseContext *context,
 		       const gchar *xpath,
+		       XbSiloQueryAxis axis,
 		       GError **error)
 {
 	g_autoptr(XbQuerySection) section = g_slice_new0(XbQuerySection);
 	guint start = 0;
 
+	/* explicit axis */
+	if (g_str_has_prefix(xpath, "descendant::")) {
+		xpath += strlen("descendant::");
+		axis = XB_SILO_QUERY_AXIS_DESCENDANT;
+	}
+	section->axis = axis;
+
 	/* common XPath sections */
 	if (g_strcmp0(xpath, "parent::*") == 0 || g_strcmp0(xpath, "..") == 0) {
+		if (axis != XB_SILO_QUERY_AXIS_CHILD) {
+			g_set_error_literal(error,
+					    G_IO_ERROR,
+					    G_IO_ERROR_NOT_SUPPORTED,
+					    "descendant axis not supported for parent");
+			return NULL;
+		}
 		section->kind = XB_SILO_QUERY_KIND_PARENT;
 		return g_steal_pointer(&section);
 	}
@@ -435,9 +702,16 @@ xb_query_parse_section(XbQuery *self,
 	}
 
 	/* This may result in @element_idx being set to %XB_SILO_UNSET if the
-	 * given element (`section->element`) is not in the silo at all. Ignore
-	 * that for now, and return no matches when the query is actually run. */
+	 * given element (`section->element`) is not in the silo at all. The
+	 * query is then marked as never matching here, so running it returns
+	 * no results without visiting any nodes. */
 	section->element_idx = xb_silo_get_strtab_idx(context->silo, section->element);
+	if (section->element_idx == XB_SILO_UNSET) {
+		XbQueryPrivate *priv = GET_PRIVATE(self);
+		priv->never_matches = TRUE;
+	} else {
+		xb_query_plan_section(self, context, section);
+	}
 
 	return g_steal_pointer(&section);
 }
@@ -448,6 +722,7 @@ xb_query_parse(XbQuery *self, XbQueryParseContext *context, const gchar *xpath,
 {
 	XbQueryPrivate *priv = GET_PRIVATE(self);
 	XbQuerySection *section;
+	XbSiloQueryAxis axis = XB_SILO_QUERY_AXIS_CHILD;
 	g_autoptr(GString) acc = g_string_new(NULL);
 
 	//	g_debug ("parsing XPath %s", xpath);
@@ -461,6 +736,26 @@ xb_query_parse(XbQuery *self, XbQueryParseContext *context, const gchar *xpath,
 			}
 		}
 
+		/* descendant, e.g. `//id` or `component//id`, where any pending
+		 * section keeps its own axis, e.g. `//components//id` */
+		if (xpath[i] == '/' && xpath[i + 1] == '/' &&
+		    (acc->len > 0 || priv->sections->len == 0)) {
+			if (acc->len > 0) {
+				section = xb_query_parse_section(self,
+								 context,
+								 acc->str,
+								 axis,
+								 error);
+				if (section == NULL)
+					return FALSE;
+				g_ptr_array_add(priv->sections, section);
+				g_string_truncate(acc, 0);
+			}
+			axis = XB_SILO_QUERY_AXIS_DESCENDANT;
+			i += 1;
+			continue;
+		}
+
 		/* split */
 		if (xpath[i] == '/') {
 			if (acc->len == 0) {
@@ -470,24 +765,191 @@ xb_query_parse(XbQuery *self, XbQueryParseContext *context, const gchar *xpath,
 						    "xpath section empty");
 				return FALSE;
 			}
-			section = xb_query_parse_section(self, context, acc->str, error);
+			section = xb_query_parse_section(self, context, acc->str, axis, error);
 			if (section == NULL)
 				return FALSE;
 			g_ptr_array_add(priv->sections, section);
 			g_string_truncate(acc, 0);
+			axis = XB_SILO_QUERY_AXIS_CHILD;
 			continue;
 		}
 		g_string_append_c(acc, xpath[i]);
 	}
 
+	/* the value of the last section rather than the node itself */
+	if (priv->sections->len > 0 && axis == XB_SILO_QUERY_AXIS_CHILD) {
+		if (g_strcmp0(acc->str, "text()") == 0) {
+			priv->projection_text = TRUE;
+			return TRUE;
+		}
+		if (acc->str[0] == '@' && acc->str[1] != '\0' && strchr(acc->str, '[') == NULL) {
+			priv->projection_attr = g_strdup(acc->str + 1);
+			return TRUE;
+		}
+	}
+
 	/* add any remaining section */
-	section = xb_query_parse_section(self, context, acc->str, error);
+	if (acc->len == 0 && axis == XB_SILO_QUERY_AXIS_DESCENDANT) {
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_NOT_FOUND,
+				    "xpath section empty");
+		return FALSE;
+	}
+	section = xb_query_parse_section(self, context, acc->str, axis, error);
 	if (section == NULL)
 		return FALSE;
 	g_ptr_array_add(priv->sections, section);
 	return TRUE;
 }
 
+/* Substituting the bound values is only worthwhile when they are used by
+ * something other than a strtab comparison, e.g. `lower-case(?)`, or when the
+ * predicates could then be reordered by the planner. */
+static gboolean
+xb_query_should_specialize(XbQuery *self)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	guint idx_cnt = 0;
+
+	if ((priv->flags & XB_QUERY_FLAG_OPTIMIZE) == 0)
+		return FALSE;
+	for (guint i = 0; i < priv->sections->len; i++) {
+		XbQuerySection *section = g_ptr_array_index(priv->sections, i);
+		guint idx_section = idx_cnt;
+		if (section->predicates == NULL)
+			continue;
+		for (guint j = 0; j < section->predicates->len; j++) {
+			XbStack *stack = g_ptr_array_index(section->predicates, j);
+			for (guint k = 0; k < xb_stack_get_size(stack); k++) {
+				if (!xb_opcode_is_binding(xb_stack_peek(stack, k)))
+					continue;
+				if (!xb_query_get_binding_in_strtab(self, idx_cnt++))
+					return TRUE;
+			}
+		}
+		if (idx_cnt > idx_section && section->predicates->len > 1)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* an unambiguous key for the values in @bindings */
+static gchar *
+xb_query_specialized_key(XbValueBindings *bindings)
+{
+	GString *str = g_string_new(NULL);
+	XbOpcode op;
+
+	for (guint i = 0; xb_value_bindings_lookup_opcode(bindings, i, &op); i++) {
+		const gchar *tmp = xb_opcode_get_str(&op);
+		g_string_append_printf(str,
+				       "%u:%u:%u:%s;",
+				       (guint)xb_opcode_get_kind(&op),
+				       xb_opcode_get_val(&op),
+				       tmp != NULL ? (guint)strlen(tmp) : 0,
+				       tmp != NULL ? tmp : "");
+	}
+	return g_string_free(str, FALSE);
+}
+
+static XbQuery *
+xb_query_specialize(XbQuery *self, XbSilo *silo, XbValueBindings *bindings, GError **error)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	XbMachine *machine = xb_silo_get_machine(silo);
+	g_autoptr(XbQuery) query = g_object_new(XB_TYPE_QUERY, NULL);
+	XbQueryPrivate *priv_new = GET_PRIVATE(query);
+	XbQueryParseContext parse_context = {
+	    .silo = silo,
+	};
+	guint bindings_idx = 0;
+
+	priv_new->xpath = g_strdup(priv->xpath);
+	priv_new->flags = priv->flags;
+	priv_new->never_matches = priv->never_matches;
+	priv_new->projection_text = priv->projection_text;
+	priv_new->projection_attr = g_strdup(priv->projection_attr);
+	priv_new->sections = g_ptr_array_new_with_free_func((GDestroyNotify)xb_query_section_free);
+	for (guint i = 0; i < priv->sections->len; i++) {
+		XbQuerySection *section = g_ptr_array_index(priv->sections, i);
+		XbQuerySection *section_new = g_slice_new0(XbQuerySection);
+
+		section_new->element = g_strdup(section->element);
+		section_new->element_idx = section->element_idx;
+		section_new->kind = section->kind;
+		section_new->axis = section->axis;
+		g_ptr_array_add(priv_new->sections, section_new);
+		if (section->predicates == NULL)
+			continue;
+		for (guint j = 0; j < section->predicates->len; j++) {
+			XbStack *opcodes = g_ptr_array_index(section->predicates, j);
+			XbStack *opcodes_new =
+			    xb_machine_opcodes_bind(machine, opcodes, bindings, &bindings_idx, error);
+			if (opcodes_new == NULL)
+				return NULL;
+			if (!xb_query_add_predicate(query,
+						    &parse_context,
+						    section_new,
+						    opcodes_new,
+						    error))
+				return NULL;
+		}
+		if (section_new->kind == XB_SILO_QUERY_KIND_UNKNOWN &&
+		    section_new->element_idx != XB_SILO_UNSET)
+			xb_query_plan_section(query, &parse_context, section_new);
+	}
+	return g_steal_pointer(&query);
+}
+
+/* private: returns a copy of the query with the values of @bindings substituted
+ * as literals and optimized again, or %NULL if the query should be run with
+ * @bindings as normal */
+XbQuery *
+xb_query_get_specialized(XbQuery *self, XbSilo *silo, XbValueBindings *bindings)
+{
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	XbQuery *query;
+	g_autofree gchar *key = NULL;
+	g_autoptr(GError) error_local = NULL;
+
+	if (!priv->specialize)
+		return NULL;
+
+	/* already done */
+	key = xb_query_specialized_key(bindings);
+	if (key[0] == '\0')
+		return NULL;
+	g_mutex_lock(&priv->specialized_mutex);
+	if (priv->specialized != NULL) {
+		query = g_hash_table_lookup(priv->specialized, key);
+		if (query != NULL) {
+			g_object_ref(query);
+			g_mutex_unlock(&priv->specialized_mutex);
+			return query;
+		}
+	}
+	g_mutex_unlock(&priv->specialized_mutex);
+
+	query = xb_query_specialize(self, silo, bindings, &error_local);
+	if (query == NULL) {
+		g_debug("failed to specialize %s: %s", priv->xpath, error_local->message);
+		return NULL;
+	}
+
+	/* only a few sets of values are likely to be reused */
+	g_mutex_lock(&priv->specialized_mutex);
+	if (priv->specialized == NULL) {
+		priv->specialized =
+		    g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+	}
+	if (g_hash_table_size(priv->specialized) >= XB_QUERY_SPECIALIZED_MAX)
+		g_hash_table_remove_all(priv->specialized);
+	g_hash_table_replace(priv->specialized, g_steal_pointer(&key), g_object_ref(query));
+	g_mutex_unlock(&priv->specialized_mutex);
+	return query;
+}
+
 /**
  * xb_query_new_full:
  * @silo: a #XbSilo
@@ -536,6 +998,7 @@ xb_query_new_full(XbSilo *silo, const gchar *xpath, XbQueryFlags flags, GError *
 			    xpath);
 		return NULL;
 	}
+	priv->specialize = xb_query_should_specialize(self);
 
 	/* success */
 	return g_steal_pointer(&self);
@@ -566,6 +1029,8 @@ xb_query_new(XbSilo *silo, const gchar *xpath, GError **error)
 static void
 xb_query_init(XbQuery *self)
 {
+	XbQueryPrivate *priv = GET_PRIVATE(self);
+	g_mutex_init(&priv->specialized_mutex);
 }
 
 static void
@@ -574,6 +1039,10 @@ xb_query_finalize(GObject *obj)
 	XbQuery *self = XB_QUERY(obj);
 	XbQueryPrivate *priv = GET_PRIVATE(self);
 	g_ptr_array_unref(priv->sections);
+	if (priv->specialized != NULL)
+		g_hash_table_unref(priv->specialized);
+	g_mutex_clear(&priv->specialized_mutex);
+	g_free(priv->projection_attr);
 	g_free(priv->xpath);
 	G_OBJECT_CLASS(xb_query_parent_class)->finalize(obj);
 }
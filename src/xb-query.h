@@ -32,6 +32,8 @@ struct _XbQueryClass {
  * @XB_QUERY_FLAG_USE_INDEXES:		Use the indexed parameters
  * @XB_QUERY_FLAG_REVERSE:		Reverse the results order
  * @XB_QUERY_FLAG_FORCE_NODE_CACHE:	Always cache the #XbNode objects
+ * @XB_QUERY_FLAG_PARALLEL:		Split sections with many nodes across threads
+ * @XB_QUERY_FLAG_ALLOW_PARTIAL:		Return the results found so far when out of time
  *
  * The flags used for queries.
  **/
@@ -41,6 +43,8 @@ typedef enum {
 	XB_QUERY_FLAG_USE_INDEXES = 1 << 1,	 /* Since: 0.1.6 */
 	XB_QUERY_FLAG_REVERSE = 1 << 2,		 /* Since: 0.1.15 */
 	XB_QUERY_FLAG_FORCE_NODE_CACHE = 1 << 3, /* Since: 0.2.0 */
+	XB_QUERY_FLAG_PARALLEL = 1 << 4,	 /* Since: 0.3.11 */
+	XB_QUERY_FLAG_ALLOW_PARTIAL = 1 << 5,	 /* Since: 0.3.11 */
 	/*< private >*/
 	XB_QUERY_FLAG_LAST
 } XbQueryFlags;
@@ -15,6 +15,7 @@
 #include "xb-node-query.h"
 #include "xb-opcode-private.h"
 #include "xb-opcode.h"
+#include "xb-query-private.h"
 #include "xb-silo-export.h"
 #include "xb-silo-private.h"
 #include "xb-silo-query-private.h"
@@ -156,6 +157,17 @@ xb_common_func(void)
 	g_assert_false(xb_string_search("gimp", ""));
 	g_assert_false(xb_string_search("gimp", "imp"));
 	g_assert_false(xb_string_search("the gimp editor", "imp"));
+	g_assert_false(xb_string_search("gigimp", "gimp"));
+	g_assert_true(xb_string_search("gigi,gimp", "gimp"));
+	g_assert_true(xb_string_search("x GIMP", "gImP"));
+	g_assert_true(xb_string_contains("gimp", ""));
+	g_assert_true(xb_string_contains("gimp", "g"));
+	g_assert_true(xb_string_contains("gimp", "p"));
+	g_assert_true(xb_string_contains("the gimp editor", "gimp"));
+	g_assert_true(xb_string_contains("ggimp", "gimp"));
+	g_assert_false(xb_string_contains("gimp", "gimpy"));
+	g_assert_false(xb_string_contains("gim", "imp"));
+	g_assert_false(xb_string_contains(NULL, "gimp"));
 	g_assert_true(xb_string_token_valid("the"));
 	g_assert_false(xb_string_token_valid(NULL));
 	g_assert_false(xb_string_token_valid(""));
@@ -291,6 +303,10 @@ xb_predicate_optimize_func(void)
 		     {"lower-case('Fire')", "'fire'"},
 		     {"upper-case('Τάχιστη')", "'ΤΆΧΙΣΤΗ'"},
 		     {"upper-case(lower-case('Fire'))", "'FIRE'"}, /* 2nd pass */
+		     {"contains(text(),'x') and @a='b'",
+		      "'a',attr(),'b',eq(),text(),'x',contains(),and()"}, /* cheapest first */
+		     {"@a='b' or contains(text(),'x')",
+		      "'a',attr(),'b',eq(),text(),'x',contains(),or()"},
 		     /* sentinel */
 		     {NULL, NULL}};
 	const gchar *invalid[] = {"'a'='b'", "123>=999", "not(1)", NULL};
@@ -377,7 +393,7 @@ xb_builder_func(void)
 
 	/* check size */
 	bytes = xb_silo_get_bytes(silo);
-	g_assert_cmpint(g_bytes_get_size(bytes), ==, 620);
+	g_assert_cmpint(g_bytes_get_size(bytes), ==, 640);
 }
 
 static void
@@ -1002,7 +1018,7 @@ xb_builder_empty_func(void)
 
 	/* check size */
 	bytes = xb_silo_get_bytes(silo);
-	g_assert_cmpint(g_bytes_get_size(bytes), ==, 32);
+	g_assert_cmpint(g_bytes_get_size(bytes), ==, 52);
 
 	/* try to dump */
 	str = xb_silo_to_string(silo, &error);
@@ -1064,6 +1080,95 @@ xb_xpath_node_func(void)
 	g_assert_cmpint(results->len, ==, 2);
 }
 
+static void
+xb_xpath_descendant_func(void)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components origin=\"lvfs\">\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>gimp.desktop</id>\n"
+			   "    <extends><id>org.gnome.Gimp.desktop</id></extends>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>org.hughski.ColorHug2.firmware</id>\n"
+			   "    <component><id>nested</id></component>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* anywhere in the document */
+	results = xb_silo_query(silo, "//id", 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 4);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "gimp.desktop");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 3)), ==, "nested");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* descendant of a section, with nested matches only returned once */
+	results = xb_silo_query(silo, "components//component//id", 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 4);
+	g_clear_pointer(&results, g_ptr_array_unref);
+	results = xb_silo_query(silo, "//components//id", 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 4);
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* explicit axis with a predicate */
+	n = xb_silo_query_first(silo, "components/descendant::id[text()='nested']/..", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_element(n), ==, "component");
+	g_clear_object(&n);
+
+	/* relative to a node, limited to its subtree */
+	n = xb_silo_query_first(silo, "components/component[@type='desktop']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	results = xb_node_query(n, "descendant::id", 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	g_clear_pointer(&results, g_ptr_array_unref);
+	g_clear_object(&n);
+
+	/* limit */
+	results = xb_silo_query(silo, "//component", 1, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+
+	/* round trip */
+	query = xb_query_new(silo, "//components//id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	str = xb_query_to_string(query);
+	g_assert_cmpstr(str, ==, "//components//id");
+	g_clear_object(&query);
+
+	/* invalid */
+	query = xb_query_new(silo, "components//", &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(query);
+	g_clear_error(&error);
+	query = xb_query_new(silo, "components///id", &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(query);
+	g_clear_error(&error);
+}
+
 static void
 xb_node_data_func(void)
 {
@@ -1180,126 +1285,1578 @@ xb_xpath_parent_subnode_func(void)
 }
 
 static void
-xb_xpath_helpers_func(void)
+xb_xpath_helpers_func(void)
+{
+	const gchar *tmp;
+	guint64 val;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml("<release><checksum size=\"123\">456</checksum></release>",
+				    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* as char */
+	n = xb_silo_get_root(silo);
+	g_assert_nonnull(n);
+	tmp = xb_node_query_text(n, "checksum", &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(tmp, ==, "456");
+	tmp = xb_node_query_attr(n, "checksum", "size", &error);
+	g_assert_no_error(error);
+	g_assert_cmpstr(tmp, ==, "123");
+
+	/* as uint64 */
+	val = xb_node_query_text_as_uint(n, "checksum", &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(val, ==, 456);
+	val = xb_node_query_attr_as_uint(n, "checksum", "size", &error);
+	g_assert_no_error(error);
+	g_assert_cmpint(val, ==, 123);
+}
+
+static void
+xb_xpath_query_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component>\n"
+			   "    <id>n/a</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* query with slash */
+	n = xb_silo_query_first(silo, "components/component/id[text()='n\\/a']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_clear_object(&n);
+
+	/* query with an OR, where the first section contains an unknown element */
+	n = xb_silo_query_first(silo, "components/dave|components/component/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_clear_object(&n);
+
+	/* query with an OR, where the last section contains an unknown element */
+	n = xb_silo_query_first(silo, "components/component/id|components/dave", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_clear_object(&n);
+
+	/* query with an OR, where both sections find the same node */
+	results = xb_silo_query(silo, "components/component/id|components/*/id", 0, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+
+	/* query with an OR, all sections contains an unknown element */
+	n = xb_silo_query_first(silo, "components/dave|components/mike", &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(n);
+}
+
+static void
+xb_xpath_query_iter_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) str = g_string_new(NULL);
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	guint cnt = 0;
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>a</id>\n"
+			   "    <id>b</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>c</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* all results, without creating nodes */
+	query = xb_query_new(silo, "components/component/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	{
+		g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+		xb_silo_query_iter_init(&iter, silo, query, NULL);
+		while (xb_silo_query_iter_next(&iter, NULL, &error))
+			g_string_append(str, xb_silo_query_iter_get_text(&iter));
+		g_assert_no_error(error);
+		g_assert_cmpstr(str->str, ==, "abc");
+		g_assert_false(xb_silo_query_iter_next(&iter, NULL, &error));
+		g_assert_no_error(error);
+	}
+
+	/* limit */
+	{
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+		xb_query_context_set_limit(&context, 2);
+		xb_silo_query_iter_init(&iter, silo, query, &context);
+		while (xb_silo_query_iter_next(&iter, NULL, &error))
+			cnt++;
+		g_assert_no_error(error);
+		g_assert_cmpint(cnt, ==, 2);
+	}
+	g_clear_object(&query);
+
+	/* bound values, creating a node */
+	query = xb_query_new(silo, "components/component[@type=?]/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	{
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+					   0,
+					   "firmware",
+					   NULL);
+		xb_silo_query_iter_init(&iter, silo, query, &context);
+		g_assert_true(xb_silo_query_iter_next(&iter, &n, &error));
+		g_assert_no_error(error);
+		g_assert_nonnull(n);
+		g_assert_cmpstr(xb_node_get_text(n), ==, "c");
+		g_assert_false(xb_silo_query_iter_next(&iter, NULL, &error));
+		g_assert_no_error(error);
+	}
+	g_clear_object(&query);
+
+	/* each parent only once, stopping early */
+	query = xb_query_new(silo, "components/component/id/..", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	{
+		g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+		xb_silo_query_iter_init(&iter, silo, query, NULL);
+		g_assert_true(xb_silo_query_iter_next(&iter, NULL, &error));
+		g_assert_cmpstr(xb_silo_query_iter_get_attr(&iter, "type"), ==, "desktop");
+		g_assert_true(xb_silo_query_iter_next(&iter, NULL, &error));
+		g_assert_cmpstr(xb_silo_query_iter_get_attr(&iter, "type"), ==, "firmware");
+	}
+}
+
+static void
+xb_xpath_query_count_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>a</id>\n"
+			   "    <id>b</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>c</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* count */
+	query = xb_query_new(silo, "components/component/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_cmpint(xb_silo_query_count(silo, query, NULL, &error), ==, 3);
+	g_assert_no_error(error);
+	g_assert_true(xb_silo_query_exists(silo, query, NULL, &error));
+	g_assert_no_error(error);
+	g_clear_object(&query);
+
+	/* nothing */
+	query = xb_query_new(silo, "components/component[@type='dave']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_cmpint(xb_silo_query_count(silo, query, NULL, &error), ==, 0);
+	g_assert_no_error(error);
+	g_assert_false(xb_silo_query_exists(silo, query, NULL, &error));
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_clear_error(&error);
+	g_clear_object(&query);
+
+	/* count() function */
+	n = xb_silo_query_first(silo, "components/component[count('id')=1]", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_attr(n, "type"), ==, "firmware");
+	g_clear_object(&n);
+	n = xb_silo_query_first(silo, "components[count('*')>1]", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+}
+
+static void
+xb_xpath_query_texts_func(void)
+{
+	g_autofree gchar *str = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) values = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>a</id>\n"
+			   "    <id>b</id>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>c</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* texts */
+	query = xb_query_new(silo, "components/component/id/text()", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	str = xb_query_to_string(query);
+	g_assert_cmpstr(str, ==, "components/component/id/text()");
+	values = xb_silo_query_texts(silo, query, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(values);
+	g_assert_cmpint(values->len, ==, 3);
+	g_assert_cmpstr(g_ptr_array_index(values, 0), ==, "a");
+	g_assert_cmpstr(g_ptr_array_index(values, 2), ==, "c");
+	g_clear_pointer(&values, g_ptr_array_unref);
+
+	/* texts, reversed */
+	xb_query_context_set_flags(&context,
+				   XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_USE_INDEXES |
+				       XB_QUERY_FLAG_REVERSE);
+	values = xb_silo_query_texts(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(values);
+	g_assert_cmpint(values->len, ==, 3);
+	g_assert_cmpstr(g_ptr_array_index(values, 0), ==, "c");
+	g_assert_cmpstr(g_ptr_array_index(values, 2), ==, "a");
+	g_clear_pointer(&values, g_ptr_array_unref);
+	g_clear_object(&query);
+
+	/* attributes, skipping nodes without the attribute */
+	query = xb_query_new(silo, "components/component", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	values = xb_silo_query_attrs(silo, query, NULL, "type", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(values);
+	g_assert_cmpint(values->len, ==, 1);
+	g_assert_cmpstr(g_ptr_array_index(values, 0), ==, "desktop");
+	g_clear_pointer(&values, g_ptr_array_unref);
+	g_clear_object(&query);
+
+	/* attribute in the XPath */
+	query = xb_query_new(silo, "components/component/@type", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	values = xb_silo_query_texts(silo, query, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(values);
+	g_assert_cmpint(values->len, ==, 1);
+	g_assert_cmpstr(g_ptr_array_index(values, 0), ==, "desktop");
+	g_clear_pointer(&values, g_ptr_array_unref);
+	g_clear_object(&query);
+
+	/* nothing */
+	query = xb_query_new(silo, "components/component/@dave", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	values = xb_silo_query_texts(silo, query, NULL, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(values);
+}
+
+static void
+xb_xpath_query_order_func(void)
+{
+	XbNode *n;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(GPtrArray) values = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	const gchar *xml = "<releases>\n"
+			   "  <release version=\"1.2\" timestamp=\"200\"/>\n"
+			   "  <release version=\"1.10\" timestamp=\"1000\"/>\n"
+			   "  <release version=\"1.1\" timestamp=\"100\"/>\n"
+			   "  <release version=\"0.9\"/>\n"
+			   "  <release version=\"1.3\" timestamp=\"300\"/>\n"
+			   "</releases>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	query = xb_query_new(silo, "releases/release", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+
+	/* newest two, numerically */
+	xb_query_context_set_limit(&context, 2);
+	xb_query_context_set_order(&context,
+				   "@timestamp",
+				   XB_QUERY_ORDER_FLAG_NUMERIC | XB_QUERY_ORDER_FLAG_DESCENDING);
+	results = xb_silo_query_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	n = g_ptr_array_index(results, 0);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "1.10");
+	n = g_ptr_array_index(results, 1);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "1.3");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* all of them, lexically, with the missing value last */
+	xb_query_context_set_limit(&context, 0);
+	xb_query_context_set_order(&context, "@timestamp", XB_QUERY_ORDER_FLAG_NONE);
+	results = xb_silo_query_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 5);
+	n = g_ptr_array_index(results, 0);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "1.1");
+	n = g_ptr_array_index(results, 1);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "1.10");
+	n = g_ptr_array_index(results, 4);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "0.9");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* the oldest one */
+	xb_query_context_set_order(&context, "@timestamp", XB_QUERY_ORDER_FLAG_NUMERIC);
+	n = xb_silo_query_first_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_attr(n, "version"), ==, "1.1");
+	g_object_unref(n);
+
+	/* just the attributes, in the same order */
+	values = xb_silo_query_attrs(silo, query, &context, "version", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(values);
+	g_assert_cmpint(values->len, ==, 5);
+	g_assert_cmpstr(g_ptr_array_index(values, 0), ==, "1.1");
+	g_assert_cmpstr(g_ptr_array_index(values, 3), ==, "1.10");
+	g_assert_cmpstr(g_ptr_array_index(values, 4), ==, "0.9");
+}
+
+static void
+xb_xpath_query_profile_func(void)
+{
+	g_autofree gchar *str = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbQueryProfile) profile = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>a</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>b</id>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>c</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* run with a profile */
+	query = xb_query_new(silo, "components/component[@type='desktop']/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	results = xb_silo_query_with_profile(silo, query, NULL, &profile, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	g_assert_nonnull(profile);
+	g_assert_cmpint(xb_query_profile_get_results(profile), ==, 2);
+	g_assert_cmpint(xb_query_profile_get_section_count(profile), ==, 3);
+	g_assert_cmpint(xb_query_profile_get_section_visited(profile, 1), ==, 3);
+	g_assert_cmpint(xb_query_profile_get_section_matched(profile, 1), ==, 2);
+	g_assert_cmpint(xb_query_profile_get_section_visited(profile, 2), ==, 2);
+	g_assert_cmpint(xb_query_profile_get_predicate_count(profile, 1), ==, 1);
+	g_assert_cmpint(xb_query_profile_get_predicate_evaluations(profile, 1, 0), ==, 3);
+	g_assert_cmpint(xb_query_profile_get_predicate_matches(profile, 1, 0), ==, 2);
+	g_assert_cmpint(xb_query_profile_get_predicate_count(profile, 2), ==, 0);
+	str = xb_query_profile_to_string(profile);
+	g_assert_nonnull(str);
+	g_debug("\n%s", str);
+	g_clear_object(&profile);
+	g_clear_object(&query);
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* the profile is set even without results */
+	query = xb_query_new(silo, "components/component[@type='dave']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	results = xb_silo_query_with_profile(silo, query, NULL, &profile, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+	g_assert_nonnull(profile);
+	g_assert_cmpint(xb_query_profile_get_results(profile), ==, 0);
+	g_clear_object(&profile);
+	g_clear_object(&query);
+
+	/* the profile is for the copy of the query with the bound values */
+	query = xb_query_new(silo, "components/component[@type=?][@type!='addon']/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, "desktop", NULL);
+	results = xb_silo_query_with_profile(silo, query, &context, &profile, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	g_assert_cmpint(xb_query_profile_get_predicate_count(profile, 1), >, 0);
+	g_assert_cmpint(xb_query_profile_get_predicate_evaluations(profile, 1, 0), ==, 3);
+	g_clear_pointer(&str, g_free);
+	str = xb_query_profile_to_string(profile);
+	g_assert_nonnull(g_strstr_len(str, -1, "'desktop'"));
+}
+
+static void
+xb_xpath_query_plan_func(void)
+{
+	g_autofree gchar *str1 = NULL;
+	g_autofree gchar *str2 = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbQuery) query1 = NULL;
+	g_autoptr(XbQuery) query2 = NULL;
+	g_autoptr(XbQuery) query3 = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\" name=\"a\"/>\n"
+			   "  <component type=\"desktop\" name=\"b\"/>\n"
+			   "  <component type=\"desktop\" name=\"c\"/>\n"
+			   "  <component type=\"firmware\" name=\"d\"/>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* the rarest value is checked first */
+	query1 = xb_query_new(silo, "components/component[@type='desktop'][@name='b']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query1);
+	query2 = xb_query_new(silo, "components/component[@name='b'][@type='desktop']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query2);
+	str1 = xb_query_to_string(query1);
+	str2 = xb_query_to_string(query2);
+	g_assert_cmpstr(str1, ==, str2);
+	results = xb_silo_query_full(silo, query1, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* the value is in the silo, but not for this attribute */
+	query3 = xb_query_new(silo, "components/component[@type='desktop'][@name='firmware']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query3);
+	results = xb_silo_query_full(silo, query3, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+}
+
+static void
+xb_xpath_query_specialize_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\" name=\"a\"/>\n"
+			   "  <component type=\"desktop\" name=\"b\"/>\n"
+			   "  <component type=\"firmware\" name=\"c\"/>\n"
+			   "</components>\n";
+	const gchar *types[] = {"DESKTOP", "Firmware", "DESKTOP", "addon", NULL};
+	guint results_len[] = {2, 1, 2, 0};
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* the bound value is only known when the query is run */
+	query = xb_query_new(silo, "components/component[lower-case(@type)=lower-case(?)]", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	for (guint i = 0; types[i] != NULL; i++) {
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+					   0,
+					   types[i],
+					   NULL);
+		results = xb_silo_query_with_context(silo, query, &context, &error);
+		if (results_len[i] == 0) {
+			g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+			g_assert_null(results);
+			g_clear_error(&error);
+			continue;
+		}
+		g_assert_no_error(error);
+		g_assert_nonnull(results);
+		g_assert_cmpint(results->len, ==, results_len[i]);
+		g_clear_pointer(&results, g_ptr_array_unref);
+	}
+}
+
+static void
+xb_xpath_query_budget_func(void)
+{
+	g_autoptr(GCancellable) cancellable = g_cancellable_new();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(GString) xml = g_string_new("<components>\n");
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	for (guint i = 0; i < 1000; i++)
+		g_string_append_printf(xml, "  <component><id>%u</id></component>\n", i);
+	g_string_append(xml, "</components>\n");
+	silo = xb_silo_new_from_xml(xml->str, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	query = xb_query_new(silo, "components/component", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+
+	/* out of nodes to visit */
+	{
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		xb_query_context_set_max_visits(&context, 10);
+		results = xb_silo_query_with_context(silo, query, &context, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+		g_assert_null(results);
+		g_clear_error(&error);
+
+		/* the root counts as a visit */
+		xb_query_context_set_flags(&context,
+					   XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_USE_INDEXES |
+					       XB_QUERY_FLAG_ALLOW_PARTIAL);
+		results = xb_silo_query_with_context(silo, query, &context, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(results);
+		g_assert_cmpint(results->len, ==, 9);
+		g_clear_pointer(&results, g_ptr_array_unref);
+	}
+
+	/* counting and batches visit the same nodes */
+	{
+		guint cnt;
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_auto(XbQueryContext) context_all = XB_QUERY_CONTEXT_INIT();
+		g_autoptr(GPtrArray) contexts = g_ptr_array_new();
+		g_autoptr(GPtrArray) queries = g_ptr_array_new();
+
+		xb_query_context_set_max_visits(&context, 10);
+		cnt = xb_silo_query_count(silo, query, &context, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+		g_assert_cmpint(cnt, ==, 0);
+		g_clear_error(&error);
+
+		g_ptr_array_add(queries, query);
+		g_ptr_array_add(queries, query);
+		g_ptr_array_add(contexts, &context_all);
+		g_ptr_array_add(contexts, &context);
+		results = xb_silo_query_batch(silo, queries, contexts, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT);
+		g_assert_null(results);
+		g_clear_error(&error);
+
+		xb_query_context_set_flags(&context,
+					   XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_USE_INDEXES |
+					       XB_QUERY_FLAG_ALLOW_PARTIAL);
+		cnt = xb_silo_query_count(silo, query, &context, &error);
+		g_assert_no_error(error);
+		g_assert_cmpint(cnt, ==, 9);
+	}
+
+	/* cancelled, even with partial results allowed */
+	{
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		xb_query_context_set_flags(&context,
+					   XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_USE_INDEXES |
+					       XB_QUERY_FLAG_ALLOW_PARTIAL);
+		xb_query_context_set_cancellable(&context, cancellable);
+		g_cancellable_cancel(cancellable);
+		results = xb_silo_query_with_context(silo, query, &context, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+		g_assert_null(results);
+	}
+}
+
+static void
+xb_xpath_query_union_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component><id>a</id><pkgname>pa</pkgname></component>\n"
+			   "  <component><id>b</id><pkgname>pb</pkgname></component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* the shared sections are run once, but results are in the order of
+	 * the parts and each node is only returned once */
+	results = xb_silo_query(silo,
+				"components/component/id|components/component/pkgname|"
+				"components/*/id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 4);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "a");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 1)), ==, "b");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 2)), ==, "pa");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 3)), ==, "pb");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* a repeated part keeps the position of its first use */
+	results = xb_silo_query(silo,
+				"components/component/id|components/component/pkgname|"
+				"components/component/id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 4);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "a");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 2)), ==, "pa");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* the limit is shared between the parts */
+	results = xb_silo_query(silo, "components/component/id|components/component/pkgname", 2, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 1)), ==, "b");
+	g_clear_pointer(&results, g_ptr_array_unref);
+	results = xb_silo_query(silo, "components/component/id|components/component/pkgname", 3, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 3);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 2)), ==, "pa");
+}
+
+static gboolean
+xb_builder_fixup_tokenize_check_cb(XbBuilderFixup *self,
+				   XbBuilderNode *bn,
+				   gpointer user_data,
+				   GError **error)
+{
+	GPtrArray *tokens;
+
+	if (g_strcmp0(xb_builder_node_get_element(bn), "name") != 0)
+		return TRUE;
+
+	/* the tokens are still available straight away */
+	xb_builder_node_tokenize_text(bn);
+	if (g_strcmp0(xb_builder_node_get_text(bn), "Gimp Editor") == 0) {
+		tokens = xb_builder_node_get_tokens(bn);
+		g_assert_nonnull(tokens);
+		g_assert_cmpint(tokens->len, ==, 2);
+		g_assert_cmpstr(g_ptr_array_index(tokens, 0), ==, "gimp");
+	}
+	return TRUE;
+}
+
+static void
+xb_builder_tokenize_queue_func(void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GString) xml = g_string_new("<components>\n");
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+
+	/* enough nodes to tokenize in more than one thread */
+	for (guint i = 0; i < 2000; i++) {
+		g_string_append_printf(xml,
+				       "<component><id>app%04u</id>"
+				       "<name>Application%04u Café</name></component>\n",
+				       i,
+				       i);
+	}
+	g_string_append(xml, "<component><id>gimp</id><name>Gimp Editor</name></component>\n");
+	g_string_append(xml, "</components>\n");
+
+	fixup = xb_builder_fixup_new("TextTokenize",
+				     xb_builder_fixup_tokenize_check_cb,
+				     NULL,
+				     NULL);
+	xb_builder_source_add_fixup(source, fixup);
+	ret = xb_builder_source_load_xml(source, xml->str, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* both the ASCII and non-ASCII text was tokenized */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),'application1234')]/../id",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "app1234");
+	g_clear_object(&n);
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),'editor')]/../id",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp");
+	g_clear_object(&n);
+}
+
+static void
+xb_xpath_query_search_non_ascii_func(void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	const gchar *xml = "<components>\n"
+			   "  <component>\n"
+			   "    <id>editor</id>\n"
+			   "    <name>Редактор изображений</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>cafe</id>\n"
+			   "    <name>Café Société</name>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* the non-ASCII text is matched as a whole by default */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),'изображ')]/../id",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "editor");
+	g_clear_object(&n);
+	g_clear_object(&silo);
+
+	/* the non-ASCII text is tokenized without a fixup */
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder,
+				  XB_BUILDER_COMPILE_FLAG_TOKENIZE_NON_ASCII,
+				  NULL,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),'изображ')]/../id",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "editor");
+	g_clear_object(&n);
+
+	/* the bound value is tokenized once, including the ASCII alternates */
+	query = xb_query_new(silo, "components/component/name[search(text(),?)]/../id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, "SOCIETE", NULL);
+	n = xb_silo_query_first_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "cafe");
+	g_clear_object(&n);
+
+	/* only the recent bound values are kept */
+	for (guint i = 0; i < 100; i++) {
+		g_autofree gchar *tmp = g_strdup_printf("caf%u", i);
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+					   0,
+					   g_steal_pointer(&tmp),
+					   g_free);
+		n = xb_silo_query_first_with_context(silo, query, &context, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+		g_assert_null(n);
+		g_clear_error(&error);
+	}
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, "SOCIETE", NULL);
+	n = xb_silo_query_first_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "cafe");
+	g_clear_object(&n);
+}
+
+static void
+xb_xpath_query_parallel_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(GString) xml = g_string_new("<components>\n");
+	g_autoptr(GString) xml_groups = g_string_new("<groups>\n");
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbSilo) silo_groups = NULL;
+
+	/* enough siblings to be split across threads */
+	for (guint i = 0; i < 5000; i++) {
+		g_string_append_printf(xml,
+				       "  <component type=\"%s\"><id>%u</id></component>\n",
+				       i % 10 == 0 ? "firmware" : "desktop",
+				       i);
+	}
+	g_string_append(xml, "</components>\n");
+	silo = xb_silo_new_from_xml(xml->str, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* results are in document order */
+	query = xb_query_new_full(silo,
+				  "components/component[@type='firmware']/id",
+				  XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_PARALLEL,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	results = xb_silo_query_full(silo, query, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 500);
+	for (guint i = 0; i < results->len; i++) {
+		XbNode *n = g_ptr_array_index(results, i);
+		g_assert_cmpint(xb_node_get_text_as_uint(n), ==, i * 10);
+	}
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* limit */
+	{
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		xb_query_context_set_limit(&context, 3);
+		results = xb_silo_query_with_context(silo, query, &context, &error);
+		g_assert_no_error(error);
+		g_assert_nonnull(results);
+		g_assert_cmpint(results->len, ==, 3);
+		g_assert_cmpint(xb_node_get_text_as_uint(g_ptr_array_index(results, 2)), ==, 20);
+	}
+	g_clear_pointer(&results, g_ptr_array_unref);
+	g_clear_object(&query);
+
+	/* position is still counted from the first sibling */
+	query = xb_query_new_full(silo,
+				  "components/component[4321]/id",
+				  XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_PARALLEL,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	results = xb_silo_query_full(silo, query, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpint(xb_node_get_text_as_uint(g_ptr_array_index(results, 0)), ==, 4320);
+	g_clear_pointer(&results, g_ptr_array_unref);
+	g_clear_object(&query);
+
+	/* each wide section uses the same threads */
+	for (guint j = 0; j < 4; j++) {
+		g_string_append(xml_groups, "  <group>\n");
+		for (guint i = 0; i < 1000; i++) {
+			g_string_append_printf(xml_groups,
+					       "<component type=\"%s\"><id>%u</id></component>\n",
+					       i % 100 == 0 ? "firmware" : "desktop",
+					       j * 1000 + i);
+		}
+		g_string_append(xml_groups, "  </group>\n");
+	}
+	g_string_append(xml_groups, "</groups>\n");
+	silo_groups = xb_silo_new_from_xml(xml_groups->str, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo_groups);
+	query = xb_query_new_full(silo_groups,
+				  "groups/group/component[@type='firmware']/id",
+				  XB_QUERY_FLAG_OPTIMIZE | XB_QUERY_FLAG_PARALLEL,
+				  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	results = xb_silo_query_full(silo_groups, query, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 40);
+	for (guint i = 0; i < results->len; i++) {
+		XbNode *n = g_ptr_array_index(results, i);
+		g_assert_cmpint(xb_node_get_text_as_uint(n), ==, i * 100);
+	}
+}
+
+static void
+xb_xpath_query_batch_func(void)
+{
+	GPtrArray *results;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) contexts = NULL;
+	g_autoptr(GPtrArray) queries = NULL;
+	g_autoptr(GPtrArray) results_all = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xpaths[] = {"components/component[@type='firmware']/id",
+				 "components/component[@type='firmware']/provides/firmware[text()=?]",
+				 "components/component/id",
+				 "components/dave",
+				 NULL};
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>a</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>b</id>\n"
+			   "    <provides>\n"
+			   "      <firmware>1234</firmware>\n"
+			   "      <firmware>5678</firmware>\n"
+			   "    </provides>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* prepare each query */
+	queries = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+	contexts = g_ptr_array_new_with_free_func((GDestroyNotify)xb_query_context_free);
+	for (guint i = 0; xpaths[i] != NULL; i++) {
+		g_autoptr(XbQuery) query = xb_query_new(silo, xpaths[i], &error);
+		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_assert_no_error(error);
+		g_assert_nonnull(query);
+		if (i == 1) {
+			xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+						   0,
+						   "5678",
+						   NULL);
+		}
+		g_ptr_array_add(queries, g_steal_pointer(&query));
+		g_ptr_array_add(contexts, xb_query_context_copy(&context));
+	}
+
+	/* run them all at once */
+	results_all = xb_silo_query_batch(silo, queries, contexts, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results_all);
+	g_assert_cmpint(results_all->len, ==, 4);
+	results = g_ptr_array_index(results_all, 0);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "b");
+	results = g_ptr_array_index(results_all, 1);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "5678");
+	results = g_ptr_array_index(results_all, 2);
+	g_assert_cmpint(results->len, ==, 2);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "a");
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 1)), ==, "b");
+	results = g_ptr_array_index(results_all, 3);
+	g_assert_cmpint(results->len, ==, 0);
+}
+
+static void
+xb_xpath_incomplete_func(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component>\n"
+			   "    <id>gimp.desktop</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	silo = xb_silo_new_from_xml(xml, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* query with MISSING '[' */
+	n = xb_silo_query_first(silo, "components/component/id[text()='dave'", &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+	g_assert_null(n);
+}
+
+static gboolean
+xb_builder_fixup_tokenize_cb(XbBuilderFixup *self,
+			     XbBuilderNode *bn,
+			     gpointer user_data,
+			     GError **error)
+{
+	if (g_strcmp0(xb_builder_node_get_element(bn), "name") == 0)
+		xb_builder_node_tokenize_text(bn);
+	return TRUE;
+}
+
+static gboolean
+xb_builder_fixup_strip_inner_cb(XbBuilderFixup *self,
+				XbBuilderNode *bn,
+				gpointer user_data,
+				GError **error)
+{
+	if (xb_builder_node_get_first_child(bn) == NULL)
+		xb_builder_node_add_flag(bn, XB_BUILDER_NODE_FLAG_STRIP_TEXT);
+	return TRUE;
+}
+
+static void
+xb_xpath_query_search_tokens_func(void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component>\n"
+			   "    <id>gimp</id>\n"
+			   "    <name>Gimp Editor</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>inkscape</id>\n"
+			   "    <name>Inkscape</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>tagger</id>\n"
+			   "    <name>Name Tag</name>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* tokens are stored sorted at the end of the string table */
+	fixup = xb_builder_fixup_new("TextTokenize", xb_builder_fixup_tokenize_cb, NULL, NULL);
+	xb_builder_source_add_fixup(source, fixup);
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* prefix of a token */
+	results = xb_silo_query(silo,
+				"components/component/name[search(text(),'gim')]/../id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "gimp");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* prefix of the last token of a node */
+	results = xb_silo_query(silo,
+				"components/component/name[search(text(),'edi')]/../id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "gimp");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* whole token that is also an element name */
+	results = xb_silo_query(silo,
+				"components/component/name[search(text(),'name')]/../id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "tagger");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* any of several search tokens */
+	results = xb_silo_query(silo,
+				"components/component/name[search(text(),'zzz ink')]/../id",
+				0,
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_text(g_ptr_array_index(results, 0)), ==, "inkscape");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* sorts after every token */
+	results = xb_silo_query(silo,
+				"components/component/name[search(text(),'zzz')]",
+				0,
+				&error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+}
+
+static gboolean
+xb_builder_fixup_tokenize_search_cb(XbBuilderFixup *self,
+				    XbBuilderNode *bn,
+				    gpointer user_data,
+				    GError **error)
+{
+	if (g_strcmp0(xb_builder_node_get_element(bn), "name") == 0 ||
+	    g_strcmp0(xb_builder_node_get_element(bn), "summary") == 0)
+		xb_builder_node_tokenize_text(bn);
+	return TRUE;
+}
+
+static void
+xb_xpath_query_search_func(void)
+{
+	gboolean ret;
+	const gchar *fields[] = {"name", "summary", NULL};
+	const guint weights[] = {10, 1};
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	g_auto(XbQueryContext) context_bound = XB_QUERY_CONTEXT_INIT();
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbQuery) query_bound = NULL;
+	g_autoptr(XbSilo) silo = NULL;
+	const gchar *xml = "<components>\n"
+			   "  <component id=\"a\">\n"
+			   "    <name>Text Editor</name>\n"
+			   "    <summary>Edit plain text</summary>\n"
+			   "  </component>\n"
+			   "  <component id=\"b\">\n"
+			   "    <name>Image Viewer</name>\n"
+			   "    <summary>View images in an editor</summary>\n"
+			   "  </component>\n"
+			   "  <component id=\"c\">\n"
+			   "    <name>Gimp</name>\n"
+			   "    <summary>Image editor</summary>\n"
+			   "  </component>\n"
+			   "  <component id=\"d\">\n"
+			   "    <name>Calculator</name>\n"
+			   "    <summary>Add numbers</summary>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	fixup = xb_builder_fixup_new("TextTokenize", xb_builder_fixup_tokenize_search_cb, NULL, NULL);
+	xb_builder_source_add_fixup(source, fixup);
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+	query = xb_query_new(silo, "components/component", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+
+	/* a match in the name is worth more than in the summary */
+	results = xb_silo_query_search(silo,
+				       query,
+				       NULL,
+				       "editor",
+				       fields,
+				       weights,
+				       G_N_ELEMENTS(weights),
+				       XB_SILO_SEARCH_FLAG_NONE,
+				       &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 3);
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 0), "id"), ==, "a");
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 1), "id"), ==, "b");
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 2), "id"), ==, "c");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* only the best result */
+	xb_query_context_set_limit(&context, 1);
+	results = xb_silo_query_search(silo,
+				       query,
+				       &context,
+				       "editor",
+				       fields,
+				       weights,
+				       G_N_ELEMENTS(weights),
+				       XB_SILO_SEARCH_FLAG_NONE,
+				       &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 0), "id"), ==, "a");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* a token that is rare in the silo is worth more */
+	fields[1] = NULL;
+	results = xb_silo_query_search(silo,
+				       query,
+				       NULL,
+				       "gimp editor",
+				       fields,
+				       NULL,
+				       0,
+				       XB_SILO_SEARCH_FLAG_BM25,
+				       &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 2);
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 0), "id"), ==, "c");
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 1), "id"), ==, "a");
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* no matches */
+	results = xb_silo_query_search(silo,
+				       query,
+				       NULL,
+				       "zzz",
+				       fields,
+				       NULL,
+				       0,
+				       XB_SILO_SEARCH_FLAG_BM25,
+				       &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+	g_clear_error(&error);
+
+	/* a bound value on the tokenized ASCII text is matched like the text */
+	query_bound =
+	    xb_query_new(silo, "components/component/name[search(text(),?)]/..", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query_bound);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context_bound), 0, "ed", NULL);
+	results = xb_silo_query_with_context(silo, query_bound, &context_bound, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 0), "id"), ==, "a");
+	g_clear_pointer(&results, g_ptr_array_unref);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context_bound),
+				   0,
+				   "text editor",
+				   NULL);
+	results = xb_silo_query_with_context(silo, query_bound, &context_bound, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	g_assert_cmpstr(xb_node_get_attr(g_ptr_array_index(results, 0), "id"), ==, "a");
+	g_clear_pointer(&results, g_ptr_array_unref);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context_bound),
+				   0,
+				   "gimp editor",
+				   NULL);
+	results = xb_silo_query_with_context(silo, query_bound, &context_bound, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+}
+
+static void
+xb_xpath_query_search_fuzzy_func(void)
 {
-	const gchar *tmp;
-	guint64 val;
+	gboolean ret;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
 	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
 	g_autoptr(XbSilo) silo = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	const gchar *xml = "<components>\n"
+			   "  <component>\n"
+			   "    <id>gimp</id>\n"
+			   "    <name>Gimp Editor</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>inkscape</id>\n"
+			   "    <name>Inkscape</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>krita</id>\n"
+			   "    <name>Krita Painter</name>\n"
+			   "  </component>\n"
+			   "</components>\n";
 
-	/* import from XML */
-	silo = xb_silo_new_from_xml("<release><checksum size=\"123\">456</checksum></release>",
-				    &error);
+	fixup = xb_builder_fixup_new("TextTokenize", xb_builder_fixup_tokenize_cb, NULL, NULL);
+	xb_builder_source_add_fixup(source, fixup);
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
 	g_assert_no_error(error);
 	g_assert_nonnull(silo);
 
-	/* as char */
-	n = xb_silo_get_root(silo);
+	/* substitution */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'gimo',1)]/../id",
+				&error);
+	g_assert_no_error(error);
 	g_assert_nonnull(n);
-	tmp = xb_node_query_text(n, "checksum", &error);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp");
+	g_clear_object(&n);
+
+	/* deletion, in the second token */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'paintr',1)]/../id",
+				&error);
 	g_assert_no_error(error);
-	g_assert_cmpstr(tmp, ==, "456");
-	tmp = xb_node_query_attr(n, "checksum", "size", &error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "krita");
+	g_clear_object(&n);
+
+	/* insertion, then two edits */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'inksape',1)]/../id",
+				&error);
 	g_assert_no_error(error);
-	g_assert_cmpstr(tmp, ==, "123");
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "inkscape");
+	g_clear_object(&n);
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'inkskap',1)]/../id",
+				&error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(n);
+	g_clear_error(&error);
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'inkskap',2)]/../id",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "inkscape");
+	g_clear_object(&n);
 
-	/* as uint64 */
-	val = xb_node_query_text_as_uint(n, "checksum", &error);
+	/* only the tokens close to the recent bound values are kept */
+	query = xb_query_new(silo,
+			     "components/component/name[search-fuzzy(text(),?,1)]/../id",
+			     &error);
 	g_assert_no_error(error);
-	g_assert_cmpint(val, ==, 456);
-	val = xb_node_query_attr_as_uint(n, "checksum", "size", &error);
+	g_assert_nonnull(query);
+	for (guint i = 0; i < 100; i++) {
+		g_autofree gchar *tmp = g_strdup_printf("zz%u", i);
+		xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+					   0,
+					   g_steal_pointer(&tmp),
+					   g_free);
+		n = xb_silo_query_first_with_context(silo, query, &context, &error);
+		g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+		g_assert_null(n);
+		g_clear_error(&error);
+	}
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, "gimo", NULL);
+	n = xb_silo_query_first_with_context(silo, query, &context, &error);
 	g_assert_no_error(error);
-	g_assert_cmpint(val, ==, 123);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp");
+	g_clear_object(&n);
+
+	/* not tokenized */
+	n = xb_silo_query_first(silo,
+				"components/component/id[search-fuzzy(text(),'krits',1)]",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "krita");
+	g_clear_object(&n);
+
+	/* too many edits */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search-fuzzy(text(),'gimp',3)]",
+				&error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+	g_assert_null(n);
 }
 
 static void
-xb_xpath_query_func(void)
+xb_xpath_query_stem_tokens_func(void)
 {
+	gboolean ret;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderFixup) fixup = NULL;
+	g_autoptr(XbBuilderNode) app = NULL;
+	g_autoptr(XbBuilderNode) name = NULL;
+	g_autoptr(XbBuilderNode) root = xb_builder_node_new(NULL);
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
+	g_autofree gchar *str = NULL;
 	g_autoptr(XbNode) n = NULL;
 	g_autoptr(XbSilo) silo = NULL;
 	const gchar *xml = "<components>\n"
 			   "  <component>\n"
-			   "    <id>n/a</id>\n"
+			   "    <id>gimp</id>\n"
+			   "    <name>Gimp Editor</name>\n"
+			   "  </component>\n"
+			   "  <component>\n"
+			   "    <id>krita</id>\n"
+			   "    <name>Happy Painter</name>\n"
 			   "  </component>\n"
 			   "</components>\n";
 
-	/* import from XML */
-	silo = xb_silo_new_from_xml(xml, &error);
+	fixup = xb_builder_fixup_new("TextTokenize", xb_builder_fixup_tokenize_cb, NULL, NULL);
+	xb_builder_source_add_fixup(source, fixup);
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+
+	/* the token is not folded, so a stem is added even without libstemmer */
+	app = xb_builder_node_insert(root, "app", NULL);
+	name = xb_builder_node_insert(app, "name", NULL);
+	xb_builder_node_set_text(name, "Painter", -1);
+	xb_builder_node_add_token(name, "Painter");
+	xb_builder_import_node(builder, root);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_STEM_TOKENS, NULL, &error);
 	g_assert_no_error(error);
 	g_assert_nonnull(silo);
 
-	/* query with slash */
-	n = xb_silo_query_first(silo, "components/component/id[text()='n\\/a']", &error);
+	/* the nodes after the extra tokens are still valid */
+	str = xb_silo_export(silo, XB_NODE_EXPORT_FLAG_INCLUDE_SIBLINGS, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(str);
+	g_assert_nonnull(g_strstr_len(str, -1, "<app><name>Painter</name></app>"));
+	n = xb_silo_query_first(silo, "app/name[search(text(),'painter')]", &error);
 	g_assert_no_error(error);
 	g_assert_nonnull(n);
-	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_assert_cmpstr(xb_node_get_text(n), ==, "Painter");
 	g_clear_object(&n);
 
-	/* query with an OR, where the first section contains an unknown element */
-	n = xb_silo_query_first(silo, "components/dave|components/component/id", &error);
+	/* the literal is folded before searching */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),stem('EDITOR'))]/../id",
+				&error);
 	g_assert_no_error(error);
 	g_assert_nonnull(n);
-	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp");
 	g_clear_object(&n);
 
-	/* query with an OR, where the last section contains an unknown element */
-	n = xb_silo_query_first(silo, "components/component/id|components/dave", &error);
+#ifdef HAVE_LIBSTEMMER
+	/* only matches the stem of 'happy' added when compiling */
+	n = xb_silo_query_first(silo,
+				"components/component/name[search(text(),stem('happiness'))]/../id",
+				&error);
 	g_assert_no_error(error);
 	g_assert_nonnull(n);
-	g_assert_cmpstr(xb_node_get_text(n), ==, "n/a");
+	g_assert_cmpstr(xb_node_get_text(n), ==, "krita");
 	g_clear_object(&n);
-
-	/* query with an OR, all sections contains an unknown element */
-	n = xb_silo_query_first(silo, "components/dave|components/mike", &error);
-	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
-	g_assert_null(n);
+#endif
 }
 
 static void
-xb_xpath_incomplete_func(void)
+xb_xpath_query_fold_case_func(void)
 {
+	gboolean ret;
 	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbBuilderSource) source = xb_builder_source_new();
 	g_autoptr(XbNode) n = NULL;
+	g_autoptr(XbQuery) query = NULL;
 	g_autoptr(XbSilo) silo = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 	const gchar *xml = "<components>\n"
-			   "  <component>\n"
-			   "    <id>gimp.desktop</id>\n"
+			   "  <component type=\"Desktop\">\n"
+			   "    <id>Gimp.DESKTOP</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>bios</id>\n"
 			   "  </component>\n"
 			   "</components>\n";
 
-	/* import from XML */
-	silo = xb_silo_new_from_xml(xml, &error);
+	ret = xb_builder_source_load_xml(source, xml, XB_BUILDER_SOURCE_FLAG_NONE, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	xb_builder_import_source(builder, source);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_FOLD_CASE, NULL, &error);
 	g_assert_no_error(error);
 	g_assert_nonnull(silo);
 
-	/* query with MISSING '[' */
-	n = xb_silo_query_first(silo, "components/component/id[text()='dave'", &error);
-	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
-	g_assert_null(n);
-}
+	/* text */
+	n = xb_silo_query_first(silo,
+				"components/component/id[lower-case(text())='gimp.desktop']",
+				&error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "Gimp.DESKTOP");
+	g_clear_object(&n);
 
-static gboolean
-xb_builder_fixup_tokenize_cb(XbBuilderFixup *self,
-			     XbBuilderNode *bn,
-			     gpointer user_data,
-			     GError **error)
-{
-	if (g_strcmp0(xb_builder_node_get_element(bn), "name") == 0)
-		xb_builder_node_tokenize_text(bn);
-	return TRUE;
-}
+	/* already lower case */
+	n = xb_silo_query_first(silo, "components/component/id['bios'=lower-case(text())]", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "bios");
+	g_clear_object(&n);
 
-static gboolean
-xb_builder_fixup_strip_inner_cb(XbBuilderFixup *self,
-				XbBuilderNode *bn,
-				gpointer user_data,
-				GError **error)
-{
-	if (xb_builder_node_get_first_child(bn) == NULL)
-		xb_builder_node_add_flag(bn, XB_BUILDER_NODE_FLAG_STRIP_TEXT);
-	return TRUE;
+	/* attribute, with a bound value */
+	query = xb_query_new(silo, "components/component[lower-case(@type)=?]/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context), 0, "desktop", NULL);
+	n = xb_silo_query_first_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "Gimp.DESKTOP");
+	g_clear_object(&n);
+
+	/* never matches an upper case literal */
+	n = xb_silo_query_first(silo,
+				"components/component/id[lower-case(text())='Gimp.DESKTOP']",
+				&error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(n);
 }
 
 static void
@@ -1394,6 +2951,16 @@ xb_xpath_func(void)
 	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp.desktop");
 	g_clear_object(&n);
 
+	/* query with predicate logical or, short-circuited */
+	n = xb_silo_query_first(
+	    silo,
+	    "components/component/custom/value[(text()='TRUE') or contains(@key,'dave')]/../../id",
+	    &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "gimp.desktop");
+	g_clear_object(&n);
+
 	/* query that doesn't find anything */
 	n = xb_silo_query_first(silo, "dave", &error);
 	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
@@ -1935,6 +3502,92 @@ xb_xpath_prepared_func(void)
 	g_assert_cmpstr(xb_node_get_attr(n, "type"), ==, "desktop");
 }
 
+static void
+xb_xpath_interned_func(void)
+{
+	gboolean ret;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(XbBuilder) builder = xb_builder_new();
+	g_autoptr(XbSilo) silo = NULL;
+	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbNode) n = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+	const gchar *xml = "<components>\n"
+			   "  <component type=\"desktop\">\n"
+			   "    <id>gimp.desktop</id>\n"
+			   "  </component>\n"
+			   "  <component type=\"firmware\">\n"
+			   "    <id>colorhug.firmware</id>\n"
+			   "  </component>\n"
+			   "</components>\n";
+
+	/* import from XML */
+	ret = xb_test_import_xml(builder, xml, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+	silo = xb_builder_compile(builder, XB_BUILDER_COMPILE_FLAG_NONE, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(silo);
+
+	/* literals in the strtab are compared by offset */
+	query = xb_query_new(silo, "components/component[@type='firmware']/id", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_false(xb_query_get_never_matches(query));
+	n = xb_silo_query_first_full(silo, query, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(n);
+	g_assert_cmpstr(xb_node_get_text(n), ==, "colorhug.firmware");
+	g_clear_object(&n);
+	g_clear_object(&query);
+
+	/* literals not in the strtab cannot ever match */
+	query = xb_query_new(silo, "components/component/id[text()='dave.desktop']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_true(xb_query_get_never_matches(query));
+	n = xb_silo_query_first_full(silo, query, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(n);
+	g_clear_error(&error);
+	g_clear_object(&query);
+
+	/* ...but only when the comparison is required */
+	query = xb_query_new(silo, "components/component/id[text()!='dave.desktop']", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_false(xb_query_get_never_matches(query));
+	g_clear_object(&query);
+
+	/* bound strings are interned when the query is run */
+	query = xb_query_new(silo, "components/component/id[text()=?]/..", &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(query);
+	g_assert_true(xb_query_get_binding_in_strtab(query, 0));
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+				   0,
+				   "gimp.desktop",
+				   NULL);
+	results = xb_silo_query_with_context(silo, query, &context, &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(results);
+	g_assert_cmpint(results->len, ==, 1);
+	n = g_object_ref(g_ptr_array_index(results, 0));
+	g_assert_cmpstr(xb_node_get_attr(n, "type"), ==, "desktop");
+	g_clear_object(&n);
+	g_clear_pointer(&results, g_ptr_array_unref);
+
+	/* bound strings not in the strtab cannot ever match */
+	xb_value_bindings_bind_str(xb_query_context_get_bindings(&context),
+				   0,
+				   "dave.desktop",
+				   NULL);
+	results = xb_silo_query_with_context(silo, query, &context, &error);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+	g_assert_null(results);
+}
+
 static void
 xb_xpath_query_reverse_func(void)
 {
@@ -2096,6 +3749,42 @@ xb_builder_single_root_func(void)
 	g_assert_null(silo);
 }
 
+static void
+xb_string_tokenize_ascii_func(void)
+{
+	const gchar *values[] = {"Hello World, it's GIMP-2.10 image_editor!",
+				 "",
+				 "  ab  ",
+				 "abc",
+				 "x86_64 FOOBAR1234",
+				 NULL};
+	g_autoptr(GPtrArray) tokens = g_ptr_array_new_with_free_func(g_free);
+
+	/* same as GLib, but only keeping the valid tokens */
+	for (guint i = 0; values[i] != NULL; i++) {
+		g_auto(GStrv) ascii_tokens = NULL;
+		g_auto(GStrv) tokens_glib = g_str_tokenize_and_fold(values[i], NULL, &ascii_tokens);
+		guint j = 0;
+
+		g_ptr_array_set_size(tokens, 0);
+		g_assert_true(xb_string_tokenize_ascii(values[i], tokens));
+		g_assert_cmpint(g_strv_length(ascii_tokens), ==, 0);
+		for (guint k = 0; tokens_glib[k] != NULL; k++) {
+			if (!xb_string_token_valid(tokens_glib[k]))
+				continue;
+			g_assert_cmpint(j, <, tokens->len);
+			g_assert_cmpstr(g_ptr_array_index(tokens, j++), ==, tokens_glib[k]);
+		}
+		g_assert_cmpint(j, ==, tokens->len);
+	}
+
+	/* not ASCII */
+	g_ptr_array_set_size(tokens, 0);
+	g_ptr_array_add(tokens, g_strdup("existing"));
+	g_assert_false(xb_string_tokenize_ascii("Gimp Café", tokens));
+	g_assert_cmpint(tokens->len, ==, 1);
+}
+
 static void
 xb_builder_node_token_max_func(void)
 {
@@ -2746,21 +4435,44 @@ main(int argc, char **argv)
 	g_test_add_func("/libxmlb/builder{source-lzma}", xb_builder_source_lzma_func);
 	g_test_add_func("/libxmlb/builder-node", xb_builder_node_func);
 	g_test_add_func("/libxmlb/builder-node{token-max}", xb_builder_node_token_max_func);
+	g_test_add_func("/libxmlb/builder-node{tokenize-ascii}", xb_string_tokenize_ascii_func);
 	g_test_add_func("/libxmlb/builder-node{info}", xb_builder_node_info_func);
 	g_test_add_func("/libxmlb/builder-node{literal-text}", xb_builder_node_literal_text_func);
 	g_test_add_func("/libxmlb/builder-node{source-text}", xb_builder_node_source_text_func);
 	g_test_add_func("/libxmlb/markup", xb_markup_func);
 	g_test_add_func("/libxmlb/xpath", xb_xpath_func);
 	g_test_add_func("/libxmlb/xpath-query", xb_xpath_query_func);
+	g_test_add_func("/libxmlb/xpath-query{iter}", xb_xpath_query_iter_func);
+	g_test_add_func("/libxmlb/xpath-query{count}", xb_xpath_query_count_func);
+	g_test_add_func("/libxmlb/xpath-query{texts}", xb_xpath_query_texts_func);
+	g_test_add_func("/libxmlb/xpath-query{order}", xb_xpath_query_order_func);
+	g_test_add_func("/libxmlb/xpath-query{profile}", xb_xpath_query_profile_func);
+	g_test_add_func("/libxmlb/xpath-query{plan}", xb_xpath_query_plan_func);
+	g_test_add_func("/libxmlb/xpath-query{specialize}", xb_xpath_query_specialize_func);
+	g_test_add_func("/libxmlb/xpath-query{budget}", xb_xpath_query_budget_func);
+	g_test_add_func("/libxmlb/xpath-query{union}", xb_xpath_query_union_func);
+	g_test_add_func("/libxmlb/xpath-query{search-tokens}",
+			xb_xpath_query_search_tokens_func);
+	g_test_add_func("/libxmlb/xpath-query{search}", xb_xpath_query_search_func);
+	g_test_add_func("/libxmlb/xpath-query{search-fuzzy}", xb_xpath_query_search_fuzzy_func);
+	g_test_add_func("/libxmlb/xpath-query{stem-tokens}", xb_xpath_query_stem_tokens_func);
+	g_test_add_func("/libxmlb/xpath-query{fold-case}", xb_xpath_query_fold_case_func);
+	g_test_add_func("/libxmlb/builder{tokenize-queue}", xb_builder_tokenize_queue_func);
+	g_test_add_func("/libxmlb/xpath-query{search-non-ascii}",
+			xb_xpath_query_search_non_ascii_func);
+	g_test_add_func("/libxmlb/xpath-query{parallel}", xb_xpath_query_parallel_func);
+	g_test_add_func("/libxmlb/xpath-query{batch}", xb_xpath_query_batch_func);
 	g_test_add_func("/libxmlb/xpath-query{reverse}", xb_xpath_query_reverse_func);
 	g_test_add_func("/libxmlb/xpath-query{force-node-cache}",
 			xb_xpath_query_force_node_cache_func);
 	g_test_add_func("/libxmlb/xpath{helpers}", xb_xpath_helpers_func);
 	g_test_add_func("/libxmlb/xpath{prepared}", xb_xpath_prepared_func);
+	g_test_add_func("/libxmlb/xpath{interned}", xb_xpath_interned_func);
 	g_test_add_func("/libxmlb/xpath{incomplete}", xb_xpath_incomplete_func);
 	g_test_add_func("/libxmlb/xpath-parent", xb_xpath_parent_func);
 	g_test_add_func("/libxmlb/xpath-glob", xb_xpath_glob_func);
 	g_test_add_func("/libxmlb/xpath-node", xb_xpath_node_func);
+	g_test_add_func("/libxmlb/xpath-descendant", xb_xpath_descendant_func);
 	g_test_add_func("/libxmlb/xpath-parent-subnode", xb_xpath_parent_subnode_func);
 	g_test_add_func("/libxmlb/multiple-roots", xb_builder_multiple_roots_func);
 	g_test_add_func("/libxmlb/single-root", xb_builder_single_root_func);
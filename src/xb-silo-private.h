@@ -15,31 +15,106 @@
 
 G_BEGIN_DECLS
 
-/* 32 bytes, native byte order */
+/* 44 bytes, native byte order */
 typedef struct __attribute__((packed)) {
 	guint32 magic;
 	guint32 version;
 	XbGuid guid;
 	guint16 strtab_ntags;
-	guint8 padding[2];
+	guint16 flags; /* XbSiloHeaderFlags */
 	guint32 strtab;
+	guint32 strtab_tokens; /* sorted tokens, from here to the end of the strtab */
+	guint32 tokentab;      /* token statistics, from here to the foldtab */
+	guint32 foldtab;       /* lower-case strings, from here to the end of the data */
 } XbSiloHeader;
 
+typedef enum {
+	XB_SILO_HEADER_FLAG_NONE = 0,
+	XB_SILO_HEADER_FLAG_TOKENIZE_NON_ASCII = 1 << 0, /* text that is not ASCII is tokenized */
+} XbSiloHeaderFlags;
+
+/* the tokentab has the number of tokenized nodes, the total number of tokens
+ * in those nodes, and then the number of nodes with each of the sorted tokens */
+#define XB_SILO_TOKENTAB_NODES	0
+#define XB_SILO_TOKENTAB_TOKENS 1
+#define XB_SILO_TOKENTAB_DF	2
+
+/* the foldtab is empty if the silo was built without folding, otherwise it has
+ * the number of pairs and then the strtab offset of each string that is not
+ * already lower case followed by the offset of the lower case copy, sorted by
+ * the first offset */
+#define XB_SILO_FOLDTAB_PAIRS 0
+
 #define XB_SILO_MAGIC_BYTES 0x624c4d58
-#define XB_SILO_VERSION	    0x00000008
+#define XB_SILO_VERSION	    0x0000000B
+
+#define XB_SILO_QUERY_TOKEN_RANGES_MAX 8
+
+typedef struct {
+	const gchar *token;
+	const gchar *lo; /* (nullable): if no tokens start with @token */
+	const gchar *hi;
+} XbSiloQueryTokenRange;
+
+/* the largest edit distance allowed by search-fuzzy() */
+#define XB_SILO_FUZZY_DISTANCE_MAX 2
+
+typedef struct {
+	gint ref;
+	gchar *search;
+	guint max_dist;
+	GArray *tokens; /* of const gchar *, sorted by address */
+} XbSiloFuzzyTokens;
+
+typedef struct {
+	gint ref;
+	gchar *search;
+	gchar **tokens; /* the valid tokens, then the valid ASCII alternates */
+} XbSiloSearchTokens;
 
 typedef struct {
 	/*< private >*/
 	XbSiloNode *sn;
 	guint position;
+	XbSiloQueryTokenRange token_ranges[XB_SILO_QUERY_TOKEN_RANGES_MAX];
+	guint token_ranges_len;
+	XbSiloFuzzyTokens *fuzzy_tokens;   /* (nullable) (owned) */
+	XbSiloSearchTokens *search_tokens; /* (nullable) (owned) */
 } XbSiloQueryData;
 
+void
+xb_silo_query_data_clear(XbSiloQueryData *query_data);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(XbSiloQueryData, xb_silo_query_data_clear)
+
 const gchar *
 xb_silo_from_strtab(XbSilo *self, guint32 offset);
 void
 xb_silo_strtab_index_insert(XbSilo *self, guint32 offset);
 guint32
 xb_silo_strtab_index_lookup(XbSilo *self, const gchar *str);
+guint
+xb_silo_get_element_count(XbSilo *self, guint32 element_idx);
+guint
+xb_silo_get_value_count(XbSilo *self, guint32 element_idx, const gchar *attr, guint32 value_idx);
+gboolean
+xb_silo_get_token_range(XbSilo *self, const gchar *prefix, const gchar **lo, const gchar **hi);
+gboolean
+xb_silo_is_token(XbSilo *self, const gchar *token);
+guint32
+xb_silo_get_token_frequency(XbSilo *self, const gchar *token);
+void
+xb_silo_get_token_totals(XbSilo *self, guint32 *nodes, guint32 *tokens);
+XbSiloFuzzyTokens *
+xb_silo_get_fuzzy_tokens(XbSilo *self, const gchar *search, guint max_dist);
+void
+xb_silo_fuzzy_tokens_unref(XbSiloFuzzyTokens *fuzzy);
+XbSiloSearchTokens *
+xb_silo_get_search_tokens(XbSilo *self, const gchar *search);
+void
+xb_silo_search_tokens_unref(XbSiloSearchTokens *search_tokens);
+guint32
+xb_silo_get_folded_idx(XbSilo *self, guint32 offset);
 XbSiloNode *
 xb_silo_get_node(XbSilo *self, guint32 off);
 XbMachine *
@@ -58,6 +133,8 @@ XbSiloNode *
 xb_silo_get_next_node(XbSilo *self, XbSiloNode *n);
 XbSiloNode *
 xb_silo_get_child_node(XbSilo *self, XbSiloNode *n);
+guint32
+xb_silo_get_node_subtree_end(XbSilo *self, XbSiloNode *n);
 const gchar *
 xb_silo_get_node_element(XbSilo *self, XbSiloNode *n);
 const gchar *
@@ -70,6 +147,8 @@ guint
 xb_silo_get_node_depth(XbSilo *self, XbSiloNode *n);
 XbNode *
 xb_silo_create_node(XbSilo *self, XbSiloNode *sn, gboolean force_node_cache);
+XbNode *
+xb_silo_create_node_full(XbSilo *self, XbSiloNode *sn, gboolean force_node_cache, gboolean *cached);
 GTimer *
 xb_silo_start_profile(XbSilo *self);
 void
@@ -81,4 +160,7 @@ xb_silo_uninvalidate(XbSilo *self);
 XbSiloProfileFlags
 xb_silo_get_profile_flags(XbSilo *self);
 
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(XbSiloFuzzyTokens, xb_silo_fuzzy_tokens_unref)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(XbSiloSearchTokens, xb_silo_search_tokens_unref)
+
 G_END_DECLS
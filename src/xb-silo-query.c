@@ -9,12 +9,14 @@
 #include "config.h"
 
 #include <gio/gio.h>
+#include <math.h>
 #include <string.h>
 
 #include "xb-node-private.h"
 #include "xb-opcode-private.h"
 #include "xb-opcode.h"
 #include "xb-query-private.h"
+#include "xb-query-profile-private.h"
 #include "xb-silo-node.h"
 #include "xb-silo-query-private.h"
 #include "xb-stack-private.h"
@@ -30,8 +32,20 @@ xb_silo_query_node_matches(XbSilo *self,
 			   guint bindings_offset,
 			   guint *bindings_offset_end_out,
 			   gboolean *result,
+			   XbQueryProfile *profile,
+			   guint section_idx,
 			   GError **error)
 {
+	XbQueryProfileSection *stats = NULL;
+	XbMachineMethodProfile *methods = NULL;
+
+	/* only when profiling */
+	if (profile != NULL) {
+		stats = xb_query_profile_get_section(profile, section_idx);
+		methods = xb_query_profile_get_methods(profile);
+		stats->visited++;
+	}
+
 	/* we have an index into the string table */
 	if (section->element_idx != sn->element_name &&
 	    section->kind != XB_SILO_QUERY_KIND_WILDCARD) {
@@ -70,13 +84,26 @@ xb_silo_query_node_matches(XbSilo *self,
 			/* run the predicate; pass NULL for the bindings iff
 			 * (bindings == NULL), as that means we’ve been called
 			 * with pre-0.3.0-style pre-bound values */
-			if (!xb_machine_run_with_bindings(machine,
-							  opcodes,
-							  predicate_bindings_ptr,
-							  result,
-							  query_data,
-							  error))
+			if (!xb_machine_run_with_profile(machine,
+							 opcodes,
+							 predicate_bindings_ptr,
+							 result,
+							 query_data,
+							 methods,
+							 error))
 				return FALSE;
+			if (stats != NULL) {
+				stats->predicates[i].evaluations++;
+				if (*result)
+					stats->predicates[i].matches++;
+				xb_query_profile_add_bindings_copied(profile,
+								     predicate_bindings_idx);
+			}
+
+			/* all predicates have to match, so stop at the first
+			 * failure; the bindings offset is only used on success */
+			if (!*result)
+				break;
 
 			bindings_offset += predicate_bindings_idx;
 		}
@@ -84,6 +111,8 @@ xb_silo_query_node_matches(XbSilo *self,
 
 	if (bindings_offset_end_out != NULL)
 		*bindings_offset_end_out = bindings_offset;
+	if (stats != NULL && *result)
+		stats->matched++;
 
 	/* success */
 	return TRUE;
@@ -95,6 +124,7 @@ xb_silo_query_node_matches(XbSilo *self,
  * @XB_SILO_QUERY_HELPER_USE_SN: Return #XbSiloNodes as results, rather than
  *    wrapping them in #XbNode. This assumes that they’ll be wrapped later.
  * @XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE: Always cache the #XbNode objects
+ * @XB_SILO_QUERY_HELPER_PARALLEL: Split wide sections across threads
  *
  * Flags for #XbSiloQueryHelper.
  *
@@ -104,46 +134,484 @@ typedef enum {
 	XB_SILO_QUERY_HELPER_NONE = 0,
 	XB_SILO_QUERY_HELPER_USE_SN = 1 << 0,
 	XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE = 1 << 1,
+	XB_SILO_QUERY_HELPER_PARALLEL = 1 << 2,
 } XbSiloQueryHelperFlags;
 
+/* a set of nodes using one bit for each; as each node is at least
+ * sizeof(XbSiloNode) bytes long the offset can be divided down */
+typedef struct {
+	guint8 *bits; /* (nullable): allocated on first use */
+} XbSiloQuerySeen;
+
+static gboolean
+xb_silo_query_seen_add(XbSilo *self, XbSiloQuerySeen *seen, XbSiloNode *sn)
+{
+	guint32 idx = xb_silo_get_offset_for_node(self, sn) / sizeof(XbSiloNode);
+	guint8 mask = 1u << (idx % 8);
+
+	if (seen->bits == NULL)
+		seen->bits = g_new0(guint8, xb_silo_get_strtab(self) / sizeof(XbSiloNode) / 8 + 1);
+	if (seen->bits[idx / 8] & mask)
+		return FALSE;
+	seen->bits[idx / 8] |= mask;
+	return TRUE;
+}
+
+static void
+xb_silo_query_seen_clear(XbSiloQuerySeen *seen)
+{
+	g_clear_pointer(&seen->bits, g_free);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(XbSiloQuerySeen, xb_silo_query_seen_clear)
+
+/* BM25 term frequency saturation and length normalization */
+#define XB_SILO_QUERY_SCORE_K1 1.2
+#define XB_SILO_QUERY_SCORE_B  0.75
+
+typedef struct {
+	guint32 element_idx;
+	guint weight;
+} XbSiloQueryScoreField;
+
+/* the child elements and search tokens used to score each result */
+typedef struct {
+	XbSiloSearchFlags flags;
+	GArray *fields; /* of XbSiloQueryScoreField */
+	GArray *ranges; /* of XbSiloQueryTokenRange */
+	gdouble nodes;	/* tokenized nodes in the silo */
+	gdouble avgdl;	/* mean number of tokens in each of those */
+} XbSiloQueryScore;
+
+static void
+xb_silo_query_score_init(XbSilo *self,
+			 XbSiloQueryScore *score,
+			 const gchar *search,
+			 const gchar *const *fields,
+			 const guint *weights,
+			 guint weights_len,
+			 XbSiloSearchFlags flags)
+{
+	guint32 nodes = 0;
+	guint32 tokens = 0;
+	g_auto(GStrv) search_tokens = NULL;
+	g_auto(GStrv) search_ascii_tokens = NULL;
+
+	score->flags = flags;
+	score->fields = g_array_new(FALSE, FALSE, sizeof(XbSiloQueryScoreField));
+	score->ranges = g_array_new(FALSE, FALSE, sizeof(XbSiloQueryTokenRange));
+
+	/* fields not in the silo never match */
+	for (guint i = 0; fields[i] != NULL; i++) {
+		XbSiloQueryScoreField field = {
+		    .element_idx = xb_silo_get_strtab_idx(self, fields[i]),
+		    .weight = (i < weights_len) ? weights[i] : 1,
+		};
+		if (field.element_idx == XB_SILO_UNSET || field.weight == 0)
+			continue;
+		g_array_append_val(score->fields, field);
+	}
+
+	/* search tokens not in the silo never match, and the ASCII variant is
+	 * often the same token */
+	search_tokens = g_str_tokenize_and_fold(search, NULL, &search_ascii_tokens);
+	for (guint k = 0; k < 2; k++) {
+		gchar **strv = (k == 0) ? search_tokens : search_ascii_tokens;
+		for (guint i = 0; strv[i] != NULL; i++) {
+			XbSiloQueryTokenRange range = {.token = NULL};
+			gboolean seen = FALSE;
+			if (!xb_string_token_valid(strv[i]))
+				continue;
+			if (!xb_silo_get_token_range(self, strv[i], &range.lo, &range.hi))
+				continue;
+			for (guint j = 0; j < score->ranges->len && !seen; j++) {
+				XbSiloQueryTokenRange *range_tmp =
+				    &g_array_index(score->ranges, XbSiloQueryTokenRange, j);
+				seen = range_tmp->lo == range.lo && range_tmp->hi == range.hi;
+			}
+			if (!seen)
+				g_array_append_val(score->ranges, range);
+		}
+	}
+
+	xb_silo_get_token_totals(self, &nodes, &tokens);
+	score->nodes = nodes;
+	score->avgdl = nodes > 0 ? (gdouble)tokens / nodes : 1.f;
+}
+
+static void
+xb_silo_query_score_clear(XbSiloQueryScore *score)
+{
+	g_clear_pointer(&score->fields, g_array_unref);
+	g_clear_pointer(&score->ranges, g_array_unref);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(XbSiloQueryScore, xb_silo_query_score_clear)
+
+/* returns 1 for any match unless using BM25; as the tokens of each node are
+ * from the sorted region of the strtab they can be checked using the address,
+ * and the length of the field is at most %XB_OPCODE_TOKEN_MAX like the mean */
+static gdouble
+xb_silo_query_score_field(XbSilo *self, XbSiloQueryScore *score, XbSiloNode *sn)
+{
+	guint token_count = xb_silo_node_get_token_count(sn);
+	gdouble total = 0.f;
+
+	for (guint i = 0; i < score->ranges->len; i++) {
+		XbSiloQueryTokenRange *range =
+		    &g_array_index(score->ranges, XbSiloQueryTokenRange, i);
+		const gchar *token = NULL;
+		gdouble df;
+		gdouble idf;
+		guint tf = 0;
+
+		for (guint j = 0; j < token_count; j++) {
+			const gchar *tmp =
+			    xb_silo_from_strtab(self, xb_silo_node_get_token_idx(sn, j));
+			if (tmp >= range->lo && tmp < range->hi) {
+				if (token == NULL)
+					token = tmp;
+				tf++;
+			}
+		}
+		if (tf == 0)
+			continue;
+		if ((score->flags & XB_SILO_SEARCH_FLAG_BM25) == 0)
+			return 1.f;
+
+		df = xb_silo_get_token_frequency(self, token);
+		idf = log(1.f + (score->nodes - df + 0.5f) / (df + 0.5f));
+		total += idf * tf * (XB_SILO_QUERY_SCORE_K1 + 1) /
+			 (tf + XB_SILO_QUERY_SCORE_K1 * (1 - XB_SILO_QUERY_SCORE_B +
+							 XB_SILO_QUERY_SCORE_B * token_count /
+							     score->avgdl));
+	}
+	return total;
+}
+
+/* the sum of the weighted scores of each matching child element */
+static gdouble
+xb_silo_query_score_node(XbSilo *self, XbSiloQueryScore *score, XbSiloNode *sn)
+{
+	gdouble total = 0.f;
+
+	for (XbSiloNode *c = xb_silo_get_child_node(self, sn); c != NULL;
+	     c = xb_silo_get_next_node(self, c)) {
+		if (!xb_silo_node_has_flag(c, XB_SILO_NODE_FLAG_IS_TOKENIZED))
+			continue;
+		for (guint i = 0; i < score->fields->len; i++) {
+			XbSiloQueryScoreField *field =
+			    &g_array_index(score->fields, XbSiloQueryScoreField, i);
+			if (c->element_name == field->element_idx)
+				total += field->weight * xb_silo_query_score_field(self, score, c);
+		}
+	}
+	return total;
+}
+
+typedef struct {
+	XbSiloNode *sn;
+	const gchar *value; /* (nullable): or unset if not an integer when numeric */
+	gint64 num;
+	gdouble score;
+	guint idx; /* document order, so equal values stay in order */
+} XbSiloQueryOrderItem;
+
+/* the results ordered by a key or by a search score; with a limit only the
+ * best results are kept, using a heap with the worst of those at the top */
+typedef struct {
+	const gchar *attr;	 /* (nullable) */
+	const gchar *element;	 /* (nullable): if both are unset then use the text */
+	XbSiloQueryScore *score; /* (nullable): if set then the key is unused */
+	guint32 element_idx;
+	XbQueryOrderFlags flags;
+	guint limit;
+	guint cnt;
+	GArray *items; /* of XbSiloQueryOrderItem */
+} XbSiloQueryOrder;
+
+static void
+xb_silo_query_order_init(XbSilo *self,
+			 XbSiloQueryOrder *order,
+			 const gchar *key,
+			 XbQueryOrderFlags flags,
+			 guint limit)
+{
+	if (key == NULL) {
+		/* scored */
+	} else if (key[0] == '@') {
+		order->attr = key + 1;
+	} else if (g_strcmp0(key, "text()") != 0) {
+		order->element = key;
+		order->element_idx = xb_silo_get_strtab_idx(self, key);
+	}
+	order->flags = flags;
+	order->limit = limit;
+	order->items = g_array_new(FALSE, FALSE, sizeof(XbSiloQueryOrderItem));
+}
+
+static void
+xb_silo_query_order_clear(XbSiloQueryOrder *order)
+{
+	g_clear_pointer(&order->items, g_array_unref);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(XbSiloQueryOrder, xb_silo_query_order_clear)
+
+static const gchar *
+xb_silo_query_order_get_value(XbSilo *self, XbSiloQueryOrder *order, XbSiloNode *sn)
+{
+	if (order->attr != NULL) {
+		XbSiloNodeAttr *a = xb_silo_get_node_attr_by_str(self, sn, order->attr);
+		if (a == NULL)
+			return NULL;
+		return xb_silo_from_strtab(self, a->attr_value);
+	}
+	if (order->element == NULL)
+		return xb_silo_get_node_text(self, sn);
+	if (order->element_idx == XB_SILO_UNSET)
+		return NULL;
+	for (XbSiloNode *c = xb_silo_get_child_node(self, sn); c != NULL;
+	     c = xb_silo_get_next_node(self, c)) {
+		if (c->element_name == order->element_idx)
+			return xb_silo_get_node_text(self, c);
+	}
+	return NULL;
+}
+
+/* results without a value are always last */
+static gint
+xb_silo_query_order_cmp(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	XbSiloQueryOrder *order = (XbSiloQueryOrder *)user_data;
+	const XbSiloQueryOrderItem *item1 = a;
+	const XbSiloQueryOrderItem *item2 = b;
+	gint rc = 0;
+
+	if (order->score != NULL) {
+		rc = (item1->score < item2->score) - (item1->score > item2->score);
+	} else if (item1->value == NULL || item2->value == NULL) {
+		if (item1->value != item2->value)
+			return item1->value == NULL ? 1 : -1;
+	} else if (order->flags & XB_QUERY_ORDER_FLAG_NUMERIC) {
+		rc = (item1->num > item2->num) - (item1->num < item2->num);
+	} else {
+		rc = strcmp(item1->value, item2->value);
+	}
+	if (order->flags & XB_QUERY_ORDER_FLAG_DESCENDING)
+		rc = -rc;
+	if (rc != 0)
+		return rc;
+	return (item1->idx > item2->idx) - (item1->idx < item2->idx);
+}
+
+static void
+xb_silo_query_order_add(XbSilo *self, XbSiloQueryOrder *order, XbSiloNode *sn)
+{
+	XbSiloQueryOrderItem *items;
+	XbSiloQueryOrderItem item = {
+	    .sn = sn,
+	    .idx = order->cnt++,
+	};
+	guint i;
+
+	/* results without any match are not kept */
+	if (order->score != NULL) {
+		item.score = xb_silo_query_score_node(self, order->score, sn);
+		if (item.score <= 0.f)
+			return;
+	} else {
+		item.value = xb_silo_query_order_get_value(self, order, sn);
+	}
+	if (item.value != NULL && order->flags & XB_QUERY_ORDER_FLAG_NUMERIC) {
+		gchar *endptr = NULL;
+		item.num = g_ascii_strtoll(item.value, &endptr, 10);
+		if (endptr == item.value || *endptr != '\0')
+			item.value = NULL;
+	}
+
+	/* everything is sorted at the end */
+	if (order->limit == 0) {
+		g_array_append_val(order->items, item);
+		return;
+	}
+
+	/* sift up */
+	if (order->items->len < order->limit) {
+		g_array_append_val(order->items, item);
+		items = (XbSiloQueryOrderItem *)order->items->data;
+		for (i = order->items->len - 1; i > 0; i = (i - 1) / 2) {
+			XbSiloQueryOrderItem tmp = items[(i - 1) / 2];
+			if (xb_silo_query_order_cmp(&tmp, &items[i], order) >= 0)
+				break;
+			items[(i - 1) / 2] = items[i];
+			items[i] = tmp;
+		}
+		return;
+	}
+
+	/* not better than the worst result kept */
+	items = (XbSiloQueryOrderItem *)order->items->data;
+	if (xb_silo_query_order_cmp(&item, &items[0], order) >= 0)
+		return;
+
+	/* replace it and sift down */
+	items[0] = item;
+	i = 0;
+	while (TRUE) {
+		guint worst = i;
+		guint left = 2 * i + 1;
+		guint right = 2 * i + 2;
+		XbSiloQueryOrderItem tmp;
+		if (left < order->items->len &&
+		    xb_silo_query_order_cmp(&items[left], &items[worst], order) > 0)
+			worst = left;
+		if (right < order->items->len &&
+		    xb_silo_query_order_cmp(&items[right], &items[worst], order) > 0)
+			worst = right;
+		if (worst == i)
+			break;
+		tmp = items[i];
+		items[i] = items[worst];
+		items[worst] = tmp;
+		i = worst;
+	}
+}
+
+/* how often the clock and the cancellable are checked */
+#define XB_SILO_QUERY_BUDGET_INTERVAL 256
+
+typedef struct {
+	GCancellable *cancellable; /* (nullable) */
+	gint64 deadline;	   /* monotonic µs, or 0 */
+	guint timeout;		   /* ms */
+	guint max_visits;
+	gint visits; /* (atomic) */
+} XbSiloQueryBudget;
+
+/* returns %TRUE if @context sets a cancellable, a timeout or a node budget */
+static gboolean
+xb_silo_query_budget_init(XbSiloQueryBudget *budget, XbQueryContext *context)
+{
+	budget->cancellable = xb_query_context_get_cancellable(context);
+	budget->timeout = xb_query_context_get_timeout(context);
+	budget->max_visits = xb_query_context_get_max_visits(context);
+	budget->deadline = 0;
+	budget->visits = 0;
+	if (budget->timeout > 0)
+		budget->deadline = g_get_monotonic_time() + (gint64)budget->timeout * 1000;
+	return budget->cancellable != NULL || budget->timeout > 0 || budget->max_visits > 0;
+}
+
+/* returns an error if the query has been cancelled, or has run out of time or
+ * nodes to visit */
+static gboolean
+xb_silo_query_budget_check(XbSiloQueryBudget *budget, GError **error)
+{
+	guint visits = (guint)g_atomic_int_add(&budget->visits, 1) + 1;
+
+	if (budget->max_visits > 0 && visits > budget->max_visits) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_TIMED_OUT,
+			    "query visited more than %u nodes",
+			    budget->max_visits);
+		return FALSE;
+	}
+	if (visits % XB_SILO_QUERY_BUDGET_INTERVAL != 0)
+		return TRUE;
+	if (g_cancellable_set_error_if_cancelled(budget->cancellable, error))
+		return FALSE;
+	if (budget->deadline > 0 && g_get_monotonic_time() > budget->deadline) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_TIMED_OUT,
+			    "query took longer than %ums",
+			    budget->timeout);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 typedef struct {
 	GPtrArray *sections; /* of XbQuerySection */
 	GPtrArray *results;  /* of XbNode or XbSiloNode (see @flags) */
 	XbValueBindings *bindings;
-	GHashTable *results_hash; /* of sn:1 */
+	XbSiloQuerySeen *seen;	   /* (nullable): only if results could repeat */
+	XbSiloQueryOrder *order;   /* (nullable): if set, results are added at the end */
+	XbQueryProfile *profile;   /* (nullable) */
+	XbSiloQueryBudget *budget; /* (nullable): shared with any threads */
 	guint limit;
 	XbSiloQueryHelperFlags flags;
 	XbSiloQueryData *query_data;
 } XbSiloQueryHelper;
 
-static gboolean
-xb_silo_query_section_add_result(XbSilo *self, XbSiloQueryHelper *helper, XbSiloNode *sn)
+static void
+xb_silo_query_add_result(XbSilo *self, XbSiloQueryHelper *helper, XbSiloNode *sn)
 {
-	if (g_hash_table_lookup(helper->results_hash, sn) != NULL)
-		return FALSE;
 	if (helper->flags & XB_SILO_QUERY_HELPER_USE_SN) {
 		g_ptr_array_add(helper->results, sn);
 	} else {
 		gboolean force_node_cache =
 		    (helper->flags & XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE) > 0;
-		g_ptr_array_add(helper->results, xb_silo_create_node(self, sn, force_node_cache));
+		gboolean cached = FALSE;
+		g_ptr_array_add(helper->results,
+				xb_silo_create_node_full(self, sn, force_node_cache, &cached));
+		if (cached && helper->profile != NULL)
+			xb_query_profile_add_node_cache_hit(helper->profile);
+	}
+}
+
+static gboolean
+xb_silo_query_section_add_result(XbSilo *self, XbSiloQueryHelper *helper, XbSiloNode *sn)
+{
+	if (helper->seen != NULL && !xb_silo_query_seen_add(self, helper->seen, sn))
+		return FALSE;
+
+	/* any result could be better, so never stop early */
+	if (helper->order != NULL) {
+		xb_silo_query_order_add(self, helper->order, sn);
+		return FALSE;
 	}
-	g_hash_table_add(helper->results_hash, sn);
+	xb_silo_query_add_result(self, helper, sn);
 	return helper->results->len == helper->limit;
 }
 
-/*
- * @parent: (allow-none)
- */
+static gboolean
+xb_silo_query_section_node(XbSilo *self,
+			   XbSiloNode *sn,
+			   guint i,
+			   guint bindings_offset,
+			   XbSiloQueryHelper *helper,
+			   gboolean *done,
+			   GError **error);
+static gboolean
+xb_silo_query_section_parallel(XbSilo *self,
+			       XbSiloNode *sn,
+			       guint i,
+			       guint bindings_offset,
+			       XbSiloQueryHelper *helper,
+			       gboolean *handled,
+			       GError **error);
 static gboolean
 xb_silo_query_section_root(XbSilo *self,
 			   XbSiloNode *sn,
 			   guint i,
 			   guint bindings_offset,
 			   XbSiloQueryHelper *helper,
-			   GError **error)
+			   GError **error);
+
+/*
+ * @parent: (allow-none)
+ */
+static gboolean
+xb_silo_query_section(XbSilo *self,
+		      XbSiloNode *sn,
+		      guint i,
+		      guint bindings_offset,
+		      XbSiloQueryHelper *helper,
+		      GError **error)
 {
-	XbMachine *machine = xb_silo_get_machine(self);
 	XbSiloQueryData *query_data = helper->query_data;
 	XbQuerySection *section = g_ptr_array_index(helper->sections, i);
 
@@ -178,6 +646,53 @@ xb_silo_query_section_root(XbSilo *self,
 						  error);
 	}
 
+	/* split wide sections across threads */
+	if (helper->flags & XB_SILO_QUERY_HELPER_PARALLEL) {
+		gboolean handled = FALSE;
+		if (!xb_silo_query_section_parallel(self,
+						    sn,
+						    i,
+						    bindings_offset,
+						    helper,
+						    &handled,
+						    error))
+			return FALSE;
+		if (handled)
+			return TRUE;
+	}
+
+	/* descendants are contiguous in the nodetab, so scan the range */
+	if (section->axis == XB_SILO_QUERY_AXIS_DESCENDANT) {
+		guint32 off;
+		guint32 off_end;
+		if (sn == NULL) {
+			off = sizeof(XbSiloHeader);
+			off_end = xb_silo_get_strtab(self);
+		} else {
+			off = xb_silo_get_offset_for_node(self, sn) + xb_silo_node_get_size(sn);
+			off_end = xb_silo_get_node_subtree_end(self, sn);
+		}
+		query_data->position = 0;
+		while (off < off_end) {
+			gboolean done = FALSE;
+			sn = xb_silo_get_node(self, off);
+			off += xb_silo_node_get_size(sn);
+			if (!xb_silo_node_has_flag(sn, XB_SILO_NODE_FLAG_IS_ELEMENT))
+				continue;
+			if (!xb_silo_query_section_node(self,
+							sn,
+							i,
+							bindings_offset,
+							helper,
+							&done,
+							error))
+				return FALSE;
+			if (done)
+				break;
+		}
+		return TRUE;
+	}
+
 	/* no node means root */
 	if (sn == NULL) {
 		sn = xb_silo_get_root_node(self);
@@ -199,37 +714,11 @@ xb_silo_query_section_root(XbSilo *self,
 
 	/* continue matching children ".." */
 	do {
-		gboolean result = TRUE;
-		guint bindings_offset_end = 0;
-		query_data->sn = sn;
-		if (!xb_silo_query_node_matches(self,
-						machine,
-						sn,
-						section,
-						query_data,
-						helper->bindings,
-						bindings_offset,
-						&bindings_offset_end,
-						&result,
-						error))
+		gboolean done = FALSE;
+		if (!xb_silo_query_section_node(self, sn, i, bindings_offset, helper, &done, error))
 			return FALSE;
-		if (result) {
-			if (i == helper->sections->len - 1) {
-				if (xb_silo_query_section_add_result(self, helper, sn))
-					break;
-			} else {
-				if (!xb_silo_query_section_root(self,
-								sn,
-								i + 1,
-								bindings_offset_end,
-								helper,
-								error))
-					return FALSE;
-				if (helper->results->len > 0 &&
-				    helper->results->len == helper->limit)
-					break;
-			}
-		}
+		if (done)
+			break;
 		if (sn->next == 0x0)
 			break;
 		sn = xb_silo_get_node(self, sn->next);
@@ -237,79 +726,517 @@ xb_silo_query_section_root(XbSilo *self,
 	return TRUE;
 }
 
+/* runs the section @i on the children or descendants of @sn, timing it if
+ * the query is being profiled */
 static gboolean
-xb_silo_query_part(XbSilo *self,
-		   XbSiloNode *sroot,
-		   GPtrArray *results,
-		   GHashTable *results_hash,
-		   XbQuery *query,
-		   XbQueryContext *context,
-		   gboolean first_result_only,
-		   XbSiloQueryData *query_data,
-		   XbSiloQueryHelperFlags flags,
-		   GError **error)
+xb_silo_query_section_root(XbSilo *self,
+			   XbSiloNode *sn,
+			   guint i,
+			   guint bindings_offset,
+			   XbSiloQueryHelper *helper,
+			   GError **error)
 {
-	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
-	XbSiloQueryHelper helper = {
-	    .results = results,
-	    .bindings = (context != NULL) ? xb_query_context_get_bindings(context) : NULL,
-	    .limit = first_result_only	 ? 1
-		     : (context != NULL) ? xb_query_context_get_limit(context)
-					 : xb_query_get_limit(query),
-	    .flags = flags,
-	    .results_hash = results_hash,
-	    .query_data = query_data,
-	};
-	XbQueryFlags query_flags = (context != NULL) ? xb_query_context_get_flags(context)
-						     : xb_query_get_flags(query);
-	G_GNUC_END_IGNORE_DEPRECATIONS
+	XbQueryProfileSection *stats;
+	gint64 start;
+	gboolean ret;
 
-	/* find each section */
-	helper.sections = xb_query_get_sections(query);
-	if (query_flags & XB_QUERY_FLAG_FORCE_NODE_CACHE)
-		helper.flags |= XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE;
-	return xb_silo_query_section_root(self, sroot, 0, 0, &helper, error);
+	if (helper->profile == NULL)
+		return xb_silo_query_section(self, sn, i, bindings_offset, helper, error);
+	stats = xb_query_profile_get_section(helper->profile, i);
+	start = g_get_monotonic_time();
+	ret = xb_silo_query_section(self, sn, i, bindings_offset, helper, error);
+	stats->elapsed += g_get_monotonic_time() - start;
+	return ret;
 }
 
-/* Returns an array with (element-type XbSiloNode) if
- * %XB_SILO_QUERY_HELPER_USE_SN is set, and (element-type XbNode) otherwise. */
-static GPtrArray *
-silo_query_with_root(XbSilo *self,
-		     XbNode *n,
-		     const gchar *xpath,
-		     guint limit,
-		     XbSiloQueryHelperFlags flags,
-		     GError **error)
+/* runs the section @i on @sn, and sets @done if no more nodes are required */
+static gboolean
+xb_silo_query_section_node(XbSilo *self,
+			   XbSiloNode *sn,
+			   guint i,
+			   guint bindings_offset,
+			   XbSiloQueryHelper *helper,
+			   gboolean *done,
+			   GError **error)
 {
-	XbSiloNode *sn = NULL;
-	g_auto(GStrv) split = NULL;
-	g_autoptr(GHashTable) results_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
-	g_autoptr(GPtrArray) results = NULL;
-	g_autoptr(GTimer) timer = xb_silo_start_profile(self);
-	XbSiloQueryData query_data = {
-	    .sn = NULL,
-	    .position = 0,
-	};
-
-	g_return_val_if_fail(XB_IS_SILO(self), NULL);
-	g_return_val_if_fail(xpath != NULL, NULL);
-	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	XbMachine *machine = xb_silo_get_machine(self);
+	XbSiloQueryData *query_data = helper->query_data;
+	XbQuerySection *section = g_ptr_array_index(helper->sections, i);
+	gboolean result = TRUE;
+	guint bindings_offset_end = 0;
 
-	/* empty silo */
-	if (xb_silo_is_empty(self)) {
-		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "silo has no data");
-		return NULL;
+	if (helper->budget != NULL && !xb_silo_query_budget_check(helper->budget, error))
+		return FALSE;
+	query_data->sn = sn;
+	if (!xb_silo_query_node_matches(self,
+					machine,
+					sn,
+					section,
+					query_data,
+					helper->bindings,
+					bindings_offset,
+					&bindings_offset_end,
+					&result,
+					helper->profile,
+					i,
+					error))
+		return FALSE;
+	if (!result)
+		return TRUE;
+	if (i == helper->sections->len - 1) {
+		*done = xb_silo_query_section_add_result(self, helper, sn);
+		return TRUE;
 	}
+	if (!xb_silo_query_section_root(self, sn, i + 1, bindings_offset_end, helper, error))
+		return FALSE;
+	if (helper->results->len > 0 && helper->results->len == helper->limit)
+		*done = TRUE;
+	return TRUE;
+}
 
-	if (flags & XB_SILO_QUERY_HELPER_USE_SN)
-		results = g_ptr_array_new_with_free_func(NULL);
-	else
-		results = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+/* the minimum number of candidates for each thread */
+#define XB_SILO_QUERY_PARALLEL_CHUNK_MIN 256
 
-	/* subtree query */
-	if (n != NULL) {
-		sn = xb_node_get_sn(n);
-		if (xpath[0] == '/') {
+/* the chunks of one wide section that are still running */
+typedef struct {
+	GMutex mutex;
+	GCond cond;
+	guint pending; /* (mutex mutex) */
+} XbSiloQueryWait;
+
+typedef struct {
+	XbSilo *silo;
+	GPtrArray *candidates; /* (element-type XbSiloNode) */
+	guint start;
+	guint end;
+	guint i;
+	guint bindings_offset;
+	XbSiloQueryHelper helper;
+	XbSiloQueryData query_data;
+	XbSiloQuerySeen seen;
+	GError *error;
+	XbSiloQueryWait *wait;
+} XbSiloQueryChunk;
+
+static void
+xb_silo_query_chunk_run(XbSiloQueryChunk *chunk)
+{
+	for (guint k = chunk->start; k < chunk->end; k++) {
+		XbSiloNode *sn = g_ptr_array_index(chunk->candidates, k);
+		gboolean done = FALSE;
+
+		/* all the candidates match the element name */
+		chunk->query_data.position = k;
+		if (!xb_silo_query_section_node(chunk->silo,
+						sn,
+						chunk->i,
+						chunk->bindings_offset,
+						&chunk->helper,
+						&done,
+						&chunk->error))
+			return;
+		if (done)
+			return;
+	}
+}
+
+static void
+xb_silo_query_chunk_cb(gpointer data, gpointer user_data)
+{
+	XbSiloQueryChunk *chunk = (XbSiloQueryChunk *)data;
+	XbSiloQueryWait *wait = chunk->wait;
+
+	xb_silo_query_chunk_run(chunk);
+	g_mutex_lock(&wait->mutex);
+	if (--wait->pending == 0)
+		g_cond_signal(&wait->cond);
+	g_mutex_unlock(&wait->mutex);
+}
+
+/* the threads are shared by every query in the process, and are kept around
+ * between queries so that they do not have to be started each time */
+static GThreadPool *
+xb_silo_query_get_thread_pool(void)
+{
+	static gsize pool = 0;
+
+	if (g_once_init_enter(&pool)) {
+		gint max_threads = (gint)g_get_num_processors();
+		gint max_unused = g_thread_pool_get_max_unused_threads();
+		GThreadPool *pool_tmp =
+		    g_thread_pool_new(xb_silo_query_chunk_cb, NULL, max_threads, FALSE, NULL);
+		if (max_unused >= 0 && max_unused < max_threads)
+			g_thread_pool_set_max_unused_threads(max_threads);
+		g_once_init_leave(&pool, (gsize)pool_tmp);
+	}
+	return (GThreadPool *)pool;
+}
+
+/* adds the nodes that match the element name of the section @i to
+ * @candidates if set, and returns how many were found, stopping at @max if
+ * it is not zero */
+static guint
+xb_silo_query_section_candidates_full(XbSilo *self,
+				      XbSiloNode *sn,
+				      XbQuerySection *section,
+				      GPtrArray *candidates,
+				      guint max)
+{
+	guint cnt = 0;
+
+	if (section->axis == XB_SILO_QUERY_AXIS_DESCENDANT) {
+		guint32 off;
+		guint32 off_end;
+		if (sn == NULL) {
+			off = sizeof(XbSiloHeader);
+			off_end = xb_silo_get_strtab(self);
+		} else {
+			off = xb_silo_get_offset_for_node(self, sn) + xb_silo_node_get_size(sn);
+			off_end = xb_silo_get_node_subtree_end(self, sn);
+		}
+		while (off < off_end) {
+			XbSiloNode *c = xb_silo_get_node(self, off);
+			off += xb_silo_node_get_size(c);
+			if (!xb_silo_node_has_flag(c, XB_SILO_NODE_FLAG_IS_ELEMENT))
+				continue;
+			if (section->kind != XB_SILO_QUERY_KIND_WILDCARD &&
+			    section->element_idx != c->element_name)
+				continue;
+			if (candidates != NULL)
+				g_ptr_array_add(candidates, c);
+			if (++cnt == max)
+				return cnt;
+		}
+		return cnt;
+	}
+
+	sn = (sn == NULL) ? xb_silo_get_root_node(self) : xb_silo_get_child_node(self, sn);
+	for (; sn != NULL; sn = xb_silo_get_next_node(self, sn)) {
+		if (section->kind != XB_SILO_QUERY_KIND_WILDCARD &&
+		    section->element_idx != sn->element_name)
+			continue;
+		if (candidates != NULL)
+			g_ptr_array_add(candidates, sn);
+		if (++cnt == max)
+			return cnt;
+	}
+	return cnt;
+}
+
+/* returns the nodes that match the element name of the section @i */
+static GPtrArray *
+xb_silo_query_section_candidates(XbSilo *self, XbSiloNode *sn, XbQuerySection *section)
+{
+	GPtrArray *candidates = g_ptr_array_new();
+	xb_silo_query_section_candidates_full(self, sn, section, candidates, 0);
+	return candidates;
+}
+
+/* the number of elements with the name in the whole silo is already known,
+ * so most sections are not walked at all */
+static gboolean
+xb_silo_query_section_is_wide(XbSilo *self, XbSiloNode *sn, XbQuerySection *section)
+{
+	guint min = XB_SILO_QUERY_PARALLEL_CHUNK_MIN * 2;
+
+	if (section->kind != XB_SILO_QUERY_KIND_WILDCARD &&
+	    xb_silo_get_element_count(self, section->element_idx) < min)
+		return FALSE;
+	return xb_silo_query_section_candidates_full(self, sn, section, NULL, min) == min;
+}
+
+/* if there are enough candidates for section @i, runs them in chunks using a
+ * thread pool and merges the results in order; @handled is unset otherwise */
+static gboolean
+xb_silo_query_section_parallel(XbSilo *self,
+			       XbSiloNode *sn,
+			       guint i,
+			       guint bindings_offset,
+			       XbSiloQueryHelper *helper,
+			       gboolean *handled,
+			       GError **error)
+{
+	XbQuerySection *section = g_ptr_array_index(helper->sections, i);
+	XbSiloQueryWait wait = {.pending = 0};
+	GThreadPool *pool;
+	g_autoptr(GPtrArray) candidates = NULL;
+	g_autofree XbSiloQueryChunk *chunks = NULL;
+	g_autoptr(GError) error_local = NULL;
+	guint n_chunks;
+	guint chunk_sz;
+
+	/* not worth it */
+	if (helper->limit > 0 && helper->results->len >= helper->limit) {
+		*handled = TRUE;
+		return TRUE;
+	}
+	if (g_get_num_processors() < 2 || !xb_silo_query_section_is_wide(self, sn, section))
+		return TRUE;
+	candidates = xb_silo_query_section_candidates(self, sn, section);
+	n_chunks = MIN((guint)g_get_num_processors(),
+		       candidates->len / XB_SILO_QUERY_PARALLEL_CHUNK_MIN);
+	if (n_chunks < 2)
+		return TRUE;
+	chunk_sz = (candidates->len + n_chunks - 1) / n_chunks;
+
+	/* each chunk gets its own results, position and deduplication, and
+	 * never needs more results than are still required */
+	chunks = g_new0(XbSiloQueryChunk, n_chunks);
+	for (guint j = 0; j < n_chunks; j++) {
+		XbSiloQueryChunk *chunk = &chunks[j];
+		chunk->silo = self;
+		chunk->candidates = candidates;
+		chunk->start = MIN(j * chunk_sz, candidates->len);
+		chunk->end = MIN(chunk->start + chunk_sz, candidates->len);
+		chunk->i = i;
+		chunk->bindings_offset = bindings_offset;
+		chunk->wait = &wait;
+		chunk->helper = *helper;
+		chunk->helper.results = g_ptr_array_new();
+		chunk->helper.seen = (helper->seen != NULL) ? &chunk->seen : NULL;
+		chunk->helper.query_data = &chunk->query_data;
+		chunk->helper.flags |= XB_SILO_QUERY_HELPER_USE_SN;
+		chunk->helper.flags &= ~XB_SILO_QUERY_HELPER_PARALLEL;
+		chunk->helper.order = NULL;
+		if (helper->order != NULL)
+			chunk->helper.limit = 0;
+		else if (helper->limit > 0)
+			chunk->helper.limit = helper->limit - helper->results->len;
+	}
+
+	/* wait for all the chunks to finish */
+	pool = xb_silo_query_get_thread_pool();
+	g_mutex_init(&wait.mutex);
+	g_cond_init(&wait.cond);
+	wait.pending = n_chunks;
+	for (guint j = 0; j < n_chunks; j++) {
+		if (!g_thread_pool_push(pool, &chunks[j], NULL))
+			xb_silo_query_chunk_cb(&chunks[j], NULL);
+	}
+	g_mutex_lock(&wait.mutex);
+	while (wait.pending > 0)
+		g_cond_wait(&wait.cond, &wait.mutex);
+	g_mutex_unlock(&wait.mutex);
+	g_mutex_clear(&wait.mutex);
+	g_cond_clear(&wait.cond);
+
+	/* merge in document order, keeping the results found before any error */
+	for (guint j = 0; j < n_chunks && error_local == NULL; j++) {
+		XbSiloQueryChunk *chunk = &chunks[j];
+		for (guint k = 0; k < chunk->helper.results->len; k++) {
+			XbSiloNode *sn_tmp = g_ptr_array_index(chunk->helper.results, k);
+			if (xb_silo_query_section_add_result(self, helper, sn_tmp))
+				break;
+		}
+		if (chunk->error != NULL)
+			error_local = g_steal_pointer(&chunk->error);
+		if (helper->limit > 0 && helper->results->len == helper->limit)
+			break;
+	}
+	for (guint j = 0; j < n_chunks; j++) {
+		g_ptr_array_unref(chunks[j].helper.results);
+		xb_silo_query_seen_clear(&chunks[j].seen);
+		xb_silo_query_data_clear(&chunks[j].query_data);
+		g_clear_error(&chunks[j].error);
+	}
+	*handled = TRUE;
+	if (error_local != NULL) {
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* copies @bindings to @bindings_indexed, interning any bound strings so that
+ * they can be compared using the strtab offset rather than the string contents;
+ * returns %FALSE if the query can never match */
+static gboolean
+xb_silo_query_intern_bindings(XbSilo *self,
+			      XbQuery *query,
+			      XbValueBindings *bindings,
+			      XbValueBindings *bindings_indexed)
+{
+	for (guint i = 0; xb_value_bindings_copy_binding(bindings, i, bindings_indexed, i); i++) {
+		const gchar *str = xb_value_bindings_get_str(bindings_indexed, i);
+		guint32 val;
+		if (str == NULL)
+			continue;
+		val = xb_silo_strtab_index_lookup(self, str);
+		if (val == XB_SILO_UNSET) {
+			if (xb_query_get_binding_in_strtab(query, i))
+				return FALSE;
+			continue;
+		}
+		xb_value_bindings_bind_indexed_str(bindings_indexed,
+						   i,
+						   xb_silo_from_strtab(self, val),
+						   val);
+	}
+	return TRUE;
+}
+
+static gboolean
+xb_silo_query_part(XbSilo *self,
+		   XbSiloNode *sroot,
+		   GPtrArray *results,
+		   XbSiloQuerySeen *seen,
+		   XbQuery *query,
+		   XbQueryContext *context,
+		   gboolean first_result_only,
+		   XbSiloQueryData *query_data,
+		   XbSiloQueryHelperFlags flags,
+		   XbSiloQueryScore *score,
+		   XbQueryProfile *profile,
+		   GError **error)
+{
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	XbSiloQueryHelper helper = {
+	    .results = results,
+	    .bindings = (context != NULL) ? xb_query_context_get_bindings(context) : NULL,
+	    .limit = first_result_only	 ? 1
+		     : (context != NULL) ? xb_query_context_get_limit(context)
+					 : xb_query_get_limit(query),
+	    .flags = flags,
+	    .seen = seen,
+	    .profile = profile,
+	    .query_data = query_data,
+	};
+	XbQueryFlags query_flags = (context != NULL) ? xb_query_context_get_flags(context)
+						     : xb_query_get_flags(query);
+	g_auto(XbValueBindings) bindings_indexed = XB_VALUE_BINDINGS_INIT();
+	g_auto(XbSiloQueryOrder) order = {NULL};
+	XbQueryOrderFlags order_flags = XB_QUERY_ORDER_FLAG_NONE;
+	const gchar *order_key = NULL;
+	g_autoptr(XbQuery) specialized = NULL;
+	g_autoptr(GError) error_local = NULL;
+	XbSiloQueryBudget budget = {NULL};
+	G_GNUC_END_IGNORE_DEPRECATIONS
+
+	/* a literal or element name is not in the strtab */
+	if (xb_query_get_never_matches(query))
+		return TRUE;
+
+	/* use a copy of the query with the bound values as literals */
+	if (helper.bindings != NULL) {
+		specialized = xb_query_get_specialized(query, self, helper.bindings);
+		if (specialized != NULL) {
+			if (xb_query_get_never_matches(specialized))
+				return TRUE;
+			query = specialized;
+			helper.bindings = NULL;
+
+			/* the predicates may have been reordered or removed */
+			if (profile != NULL)
+				xb_query_profile_set_query(profile, query);
+		}
+	}
+
+	/* keep only the best results while running the query */
+	if (score != NULL) {
+		xb_silo_query_order_init(self, &order, NULL, order_flags, helper.limit);
+		order.score = score;
+		helper.order = &order;
+	} else {
+		if (context != NULL)
+			order_key = xb_query_context_get_order(context, &order_flags);
+		if (order_key != NULL) {
+			xb_silo_query_order_init(self,
+						 &order,
+						 order_key,
+						 order_flags,
+						 helper.limit);
+			helper.order = &order;
+		}
+	}
+
+	/* stop early if cancelled, or out of time or nodes */
+	if (context != NULL && xb_silo_query_budget_init(&budget, context))
+		helper.budget = &budget;
+
+	/* intern any bound strings */
+	if (helper.bindings != NULL) {
+		if (!xb_silo_query_intern_bindings(self, query, helper.bindings, &bindings_indexed))
+			return TRUE;
+		helper.bindings = &bindings_indexed;
+	}
+
+	/* find each section */
+	helper.sections = xb_query_get_sections(query);
+	if (query_flags & XB_QUERY_FLAG_FORCE_NODE_CACHE)
+		helper.flags |= XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE;
+	if (query_flags & XB_QUERY_FLAG_PARALLEL && profile == NULL) {
+		helper.flags |= XB_SILO_QUERY_HELPER_PARALLEL;
+	}
+	if (!xb_silo_query_section_root(self, sroot, 0, 0, &helper, &error_local)) {
+		if (!g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_TIMED_OUT) ||
+		    (query_flags & XB_QUERY_FLAG_ALLOW_PARTIAL) == 0) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return FALSE;
+		}
+		g_debug("returning partial results: %s", error_local->message);
+	}
+
+	/* add the ordered results */
+	if (helper.order != NULL) {
+		g_array_sort_with_data(order.items, xb_silo_query_order_cmp, &order);
+		for (guint i = 0; i < order.items->len; i++) {
+			XbSiloQueryOrderItem *item =
+			    &g_array_index(order.items, XbSiloQueryOrderItem, i);
+			xb_silo_query_add_result(self, &helper, item->sn);
+		}
+	}
+	return TRUE;
+}
+
+static gboolean
+xb_silo_query_union(XbSilo *self,
+		    XbSiloNode *sroot,
+		    GPtrArray *queries,
+		    GPtrArray *results,
+		    XbSiloQueryHelperFlags flags,
+		    GError **error);
+
+/* Returns an array with (element-type XbSiloNode) if
+ * %XB_SILO_QUERY_HELPER_USE_SN is set, and (element-type XbNode) otherwise. */
+static GPtrArray *
+silo_query_with_root(XbSilo *self,
+		     XbNode *n,
+		     const gchar *xpath,
+		     guint limit,
+		     XbSiloQueryHelperFlags flags,
+		     GError **error)
+{
+	XbSiloNode *sn = NULL;
+	g_auto(GStrv) split = NULL;
+	g_auto(XbSiloQuerySeen) seen = {NULL};
+	g_autoptr(GPtrArray) queries = NULL;
+	g_autoptr(GPtrArray) results = NULL;
+	g_autoptr(GError) error_last = NULL;
+	g_autoptr(GTimer) timer = xb_silo_start_profile(self);
+	g_auto(XbSiloQueryData) query_data = {
+	    .sn = NULL,
+	    .position = 0,
+	};
+
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(xpath != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	/* empty silo */
+	if (xb_silo_is_empty(self)) {
+		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "silo has no data");
+		return NULL;
+	}
+
+	if (flags & XB_SILO_QUERY_HELPER_USE_SN)
+		results = g_ptr_array_new_with_free_func(NULL);
+	else
+		results = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+
+	/* subtree query */
+	if (n != NULL) {
+		sn = xb_node_get_sn(n);
+		if (xpath[0] == '/') {
 			g_set_error_literal(error,
 					    G_IO_ERROR,
 					    G_IO_ERROR_NOT_SUPPORTED,
@@ -317,25 +1244,37 @@ silo_query_with_root(XbSilo *self,
 			return NULL;
 		}
 	} else {
-		/* assume it's just a root query */
-		if (xpath[0] == '/')
+		/* assume it's just a root query, unless it is `//` */
+		if (xpath[0] == '/' && xpath[1] != '/')
 			xpath++;
 	}
 
-	/* do 'or' searches */
+	/* compile each part of an 'or' search */
 	split = g_strsplit(xpath, "|", -1);
+	queries = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	for (guint i = 0; split[i] != NULL; i++) {
+		gboolean seen = FALSE;
 		g_autoptr(GError) error_local = NULL;
-		g_autoptr(XbQuery) query = xb_query_new(self, split[i], &error_local);
-		g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+		g_autoptr(XbQuery) query = NULL;
 
+		/* the same part twice can only find the same nodes, so keep the
+		 * first one to return the results in the same order */
+		for (guint j = 0; j < i && !seen; j++)
+			seen = g_strcmp0(split[j], split[i]) == 0;
+		if (seen)
+			continue;
+		query = xb_query_new(self, split[i], &error_local);
 		if (query == NULL) {
 			if (g_error_matches(error_local, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT) &&
-			    (split[i + 1] != NULL || results->len > 0)) {
+			    (split[i + 1] != NULL || queries->len > 0)) {
 				if (xb_silo_get_profile_flags(self) & XB_SILO_PROFILE_FLAG_DEBUG) {
 					g_debug("ignoring for OR statement: %s",
 						error_local->message);
 				}
+
+				/* only an error if the other parts find nothing */
+				if (split[i + 1] == NULL)
+					error_last = g_steal_pointer(&error_local);
 				continue;
 			}
 			g_propagate_prefixed_error(error,
@@ -344,21 +1283,49 @@ silo_query_with_root(XbSilo *self,
 						   xpath);
 			return NULL;
 		}
+		g_ptr_array_add(queries, g_steal_pointer(&query));
+	}
 
-		xb_query_context_set_limit(&context, limit);
-		if (!xb_silo_query_part(self,
-					sn,
-					results,
-					results_hash,
-					query,
-					&context,
-					FALSE,
-					&query_data,
-					flags,
-					error)) {
+	/* without a limit every part has to run to the end anyway, so run any
+	 * sections the parts have in common just once */
+	if (limit == 0 && queries->len > 1) {
+		if (!xb_silo_query_union(self, sn, queries, results, flags, error))
 			return NULL;
+	} else {
+		for (guint i = 0; i < queries->len; i++) {
+			XbQuery *query = g_ptr_array_index(queries, i);
+			g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
+
+			/* the same node can also be found by more than one part,
+			 * and the limit is shared between all of them */
+			xb_query_context_set_limit(&context, limit);
+			if (!xb_silo_query_part(self,
+						sn,
+						results,
+						queries->len > 1 || xb_query_get_may_repeat(query)
+						    ? &seen
+						    : NULL,
+						query,
+						&context,
+						FALSE,
+						&query_data,
+						flags,
+						NULL,
+						NULL,
+						error)) {
+				return NULL;
+			}
+			if (limit > 0 && results->len >= limit)
+				break;
 		}
 	}
+	if (results->len == 0 && error_last != NULL) {
+		g_propagate_prefixed_error(error,
+					   g_steal_pointer(&error_last),
+					   "failed to process %s: ",
+					   xpath);
+		return NULL;
+	}
 
 	/* profile */
 	if (xb_silo_get_profile_flags(self) & XB_SILO_PROFILE_FLAG_XPATH) {
@@ -441,43 +1408,23 @@ _g_ptr_array_reverse(GPtrArray *array)
 	}
 }
 
-/**
- * xb_silo_query_with_root_full: (skip)
- * @self: a #XbSilo
- * @n: (allow-none): a #XbNode
- * @query: an #XbQuery
- * @context: (nullable) (transfer none): context including values bound to opcodes of type
- *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
- *     the query doesn’t need any context
- * @first_result_only: %TRUE if only the first result is going to be used; this
- *     overrides the limit set in @context, and may perform other optimisations
- * @error: the #GError, or %NULL
- *
- * Searches the silo using an XPath query, returning up to @limit results.
- *
- * It is safe to call this function from a different thread to the one that
- * created the #XbSilo.
- *
- * Please note: Only a subset of XPath is supported.
- *
- * Returns: (transfer container) (element-type XbNode): results, or %NULL if unfound
- *
- * Since: 0.3.0
- **/
-GPtrArray *
-xb_silo_query_with_root_full(XbSilo *self,
-			     XbNode *n,
-			     XbQuery *query,
-			     XbQueryContext *context,
-			     gboolean first_result_only,
-			     GError **error)
+static GPtrArray *
+silo_query_with_root_full(XbSilo *self,
+			  XbNode *n,
+			  XbQuery *query,
+			  XbQueryContext *context,
+			  gboolean first_result_only,
+			  XbSiloQueryScore *score,
+			  XbQueryProfile *profile,
+			  GError **error)
 {
 	XbSiloNode *sn = NULL;
-	g_autoptr(GHashTable) results_hash = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_auto(XbSiloQuerySeen) seen = {NULL};
 	g_autoptr(GPtrArray) results =
 	    g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
 	g_autoptr(GTimer) timer = xb_silo_start_profile(self);
-	XbSiloQueryData query_data = {
+	gint64 start = (profile != NULL) ? g_get_monotonic_time() : 0;
+	g_auto(XbSiloQueryData) query_data = {
 	    .sn = NULL,
 	    .position = 0,
 	};
@@ -500,14 +1447,23 @@ xb_silo_query_with_root_full(XbSilo *self,
 	if (!xb_silo_query_part(self,
 				sn,
 				results,
-				results_hash,
+				xb_query_get_may_repeat(query) ? &seen : NULL,
 				query,
 				context,
 				first_result_only,
 				&query_data,
 				XB_SILO_QUERY_HELPER_NONE,
-				error))
+				score,
+				profile,
+				error)) {
+		if (profile != NULL)
+			xb_query_profile_set_elapsed(profile, g_get_monotonic_time() - start);
 		return NULL;
+	}
+	if (profile != NULL) {
+		xb_query_profile_set_elapsed(profile, g_get_monotonic_time() - start);
+		xb_query_profile_set_results(profile, results->len);
+	}
 
 	/* profile */
 	if (xb_silo_get_profile_flags(self) & XB_SILO_PROFILE_FLAG_XPATH) {
@@ -552,6 +1508,47 @@ xb_silo_query_with_root_full(XbSilo *self,
 	return g_steal_pointer(&results);
 }
 
+/**
+ * xb_silo_query_with_root_full: (skip)
+ * @self: a #XbSilo
+ * @n: (allow-none): a #XbNode
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @first_result_only: %TRUE if only the first result is going to be used; this
+ *     overrides the limit set in @context, and may perform other optimisations
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using an XPath query, returning up to @limit results.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbSilo.
+ *
+ * Please note: Only a subset of XPath is supported.
+ *
+ * Returns: (transfer container) (element-type XbNode): results, or %NULL if unfound
+ *
+ * Since: 0.3.0
+ **/
+GPtrArray *
+xb_silo_query_with_root_full(XbSilo *self,
+			     XbNode *n,
+			     XbQuery *query,
+			     XbQueryContext *context,
+			     gboolean first_result_only,
+			     GError **error)
+{
+	return silo_query_with_root_full(self,
+					 n,
+					 query,
+					 context,
+					 first_result_only,
+					 NULL,
+					 NULL,
+					 error);
+}
+
 /**
  * xb_silo_query_full:
  * @self: a #XbSilo
@@ -605,19 +1602,120 @@ xb_silo_query_with_context(XbSilo *self, XbQuery *query, XbQueryContext *context
 }
 
 /**
- * xb_silo_query_first_full:
+ * xb_silo_query_with_profile:
  * @self: a #XbSilo
  * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @profile: (out) (transfer full): the #XbQueryProfile for the query
  * @error: the #GError, or %NULL
  *
- * Searches the silo using an XPath query, returning up to one result.
- *
- * It is safe to call this function from a different thread to the one that
- * created the #XbSilo.
+ * Searches the silo using an XPath query, recording how many nodes each
+ * section visited, how often each predicate was true, and where the time was
+ * spent. The profile is set even if there are no results.
  *
- * Please note: Only a tiny subset of XPath 1.0 is supported.
+ * Profiling makes the query slower, and %XB_QUERY_FLAG_PARALLEL is ignored.
+ * If the query is run using a copy with the values bound in @context, the
+ * sections and predicates of the profile are those of the copy.
  *
- * Returns: (transfer none): a #XbNode, or %NULL if unfound
+ * Returns: (transfer container) (element-type XbNode): results, or %NULL if unfound
+ *
+ * Since: 0.3.11
+ **/
+GPtrArray *
+xb_silo_query_with_profile(XbSilo *self,
+			   XbQuery *query,
+			   XbQueryContext *context,
+			   XbQueryProfile **profile,
+			   GError **error)
+{
+	g_autoptr(XbQueryProfile) profile_tmp = NULL;
+	GPtrArray *results;
+
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(XB_IS_QUERY(query), NULL);
+	g_return_val_if_fail(profile != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	profile_tmp = xb_query_profile_new(query, xb_silo_get_machine(self));
+	results =
+	    silo_query_with_root_full(self, NULL, query, context, FALSE, NULL, profile_tmp, error);
+	*profile = g_steal_pointer(&profile_tmp);
+	return results;
+}
+
+/**
+ * xb_silo_query_search:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @search: the text to search for, e.g. `image editor`
+ * @fields: (array zero-terminated=1): names of child elements to search, e.g. `name`
+ * @weights: (array length=weights_len) (nullable): the weight of each of @fields, or %NULL
+ * @weights_len: the number of @weights, where any later fields have a weight of 1
+ * @flags: some #XbSiloSearchFlags, e.g. %XB_SILO_SEARCH_FLAG_BM25
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using an XPath query, returning the results that have a
+ * token starting with any of the tokens of @search in one of @fields, with
+ * the best match first.
+ *
+ * Only the tokens of each field are searched, so the fields have to be
+ * tokenized when the silo is compiled, e.g. using xb_builder_node_tokenize_text().
+ * The number of nodes with each token is recorded when the silo is compiled,
+ * so %XB_SILO_SEARCH_FLAG_BM25 ranks tokens which are rare in the silo above
+ * common ones. BM25 uses the number of tokens stored for a field as its
+ * length, and at most 32 tokens are stored, so all the longer fields are
+ * treated as having the same length.
+ *
+ * If a limit is set in @context then only that number of results are kept
+ * while the query runs; any order set in @context is ignored.
+ *
+ * Returns: (transfer container) (element-type XbNode): results, or %NULL if unfound
+ *
+ * Since: 0.3.11
+ **/
+GPtrArray *
+xb_silo_query_search(XbSilo *self,
+		     XbQuery *query,
+		     XbQueryContext *context,
+		     const gchar *search,
+		     const gchar *const *fields,
+		     const guint *weights,
+		     guint weights_len,
+		     XbSiloSearchFlags flags,
+		     GError **error)
+{
+	g_auto(XbSiloQueryScore) score = {0};
+
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(XB_IS_QUERY(query), NULL);
+	g_return_val_if_fail(search != NULL, NULL);
+	g_return_val_if_fail(fields != NULL, NULL);
+	g_return_val_if_fail(weights != NULL || weights_len == 0, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	xb_silo_query_score_init(self, &score, search, fields, weights, weights_len, flags);
+	return silo_query_with_root_full(self, NULL, query, context, FALSE, &score, NULL, error);
+}
+
+/**
+ * xb_silo_query_first_full:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using an XPath query, returning up to one result.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbSilo.
+ *
+ * Please note: Only a tiny subset of XPath 1.0 is supported.
+ *
+ * Returns: (transfer none): a #XbNode, or %NULL if unfound
  *
  * Since: 0.1.13
  **/
@@ -662,6 +1760,378 @@ xb_silo_query_first_with_context(XbSilo *self,
 	return g_object_ref(g_ptr_array_index(results, 0));
 }
 
+/* a section shared by more than one query in a batch */
+typedef struct {
+	XbQuerySection *section; /* (nullable): for the root */
+	gchar *key;
+	guint idx;		/* of the section after this one */
+	GPtrArray *children;	/* of XbSiloQueryBatchNode */
+	GArray *handoffs;	/* of guint: queries that run the remaining sections alone */
+	GArray *finals;		/* of guint: queries where this is the last section */
+	GArray *queries;	/* of guint: every query using this section */
+} XbSiloQueryBatchNode;
+
+static void
+xb_silo_query_batch_node_free(XbSiloQueryBatchNode *node)
+{
+	g_ptr_array_unref(node->children);
+	g_array_unref(node->handoffs);
+	g_array_unref(node->finals);
+	g_array_unref(node->queries);
+	g_free(node->key);
+	g_free(node);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(XbSiloQueryBatchNode, xb_silo_query_batch_node_free)
+
+static XbSiloQueryBatchNode *
+xb_silo_query_batch_node_new(XbQuerySection *section, gchar *key, guint idx)
+{
+	XbSiloQueryBatchNode *node = g_new0(XbSiloQueryBatchNode, 1);
+	node->section = section;
+	node->key = key;
+	node->idx = idx;
+	node->children =
+	    g_ptr_array_new_with_free_func((GDestroyNotify)xb_silo_query_batch_node_free);
+	node->handoffs = g_array_new(FALSE, FALSE, sizeof(guint));
+	node->finals = g_array_new(FALSE, FALSE, sizeof(guint));
+	node->queries = g_array_new(FALSE, FALSE, sizeof(guint));
+	return node;
+}
+
+/* sections using bound values cannot be shared, as each query has its own */
+static gboolean
+xb_silo_query_batch_section_is_shared(XbQuerySection *section)
+{
+	for (guint i = 0; section->predicates != NULL && i < section->predicates->len; i++) {
+		XbStack *opcodes = g_ptr_array_index(section->predicates, i);
+		for (guint j = 0; j < xb_stack_get_size(opcodes); j++) {
+			if (xb_opcode_is_binding(xb_stack_peek(opcodes, j)))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void
+xb_silo_query_batch_node_add(XbSiloQueryBatchNode *root, GPtrArray *sections, guint query_idx)
+{
+	XbSiloQueryBatchNode *node = root;
+
+	for (guint i = 0; i < sections->len; i++) {
+		XbQuerySection *section = g_ptr_array_index(sections, i);
+		XbSiloQueryBatchNode *child = NULL;
+		g_autofree gchar *str = NULL;
+		g_autofree gchar *key = NULL;
+
+		if (!xb_silo_query_batch_section_is_shared(section)) {
+			g_array_append_val(node->handoffs, query_idx);
+			return;
+		}
+		str = xb_query_section_to_string(section);
+		key = g_strdup_printf("%s%s",
+				      section->axis == XB_SILO_QUERY_AXIS_DESCENDANT ? "//" : "",
+				      str);
+		for (guint j = 0; j < node->children->len; j++) {
+			XbSiloQueryBatchNode *tmp = g_ptr_array_index(node->children, j);
+			if (g_strcmp0(tmp->key, key) == 0) {
+				child = tmp;
+				break;
+			}
+		}
+		if (child == NULL) {
+			child = xb_silo_query_batch_node_new(section, g_steal_pointer(&key), i + 1);
+			g_ptr_array_add(node->children, child);
+		}
+		g_array_append_val(child->queries, query_idx);
+		node = child;
+	}
+	g_array_append_val(node->finals, query_idx);
+}
+
+static gboolean
+xb_silo_query_batch_is_done(XbSiloQueryHelper *helper)
+{
+	return helper->limit > 0 && helper->results->len >= helper->limit;
+}
+
+static gboolean
+xb_silo_query_batch_walk(XbSilo *self,
+			 XbSiloQueryBatchNode *node,
+			 XbSiloNode *sn,
+			 XbSiloQueryHelper *helpers,
+			 XbSiloQueryData *query_data,
+			 GError **error)
+{
+	XbMachine *machine = xb_silo_get_machine(self);
+
+	/* the rest of these queries are not shared */
+	for (guint i = 0; i < node->handoffs->len; i++) {
+		XbSiloQueryHelper *helper = &helpers[g_array_index(node->handoffs, guint, i)];
+		if (xb_silo_query_batch_is_done(helper))
+			continue;
+		if (!xb_silo_query_section_root(self, sn, node->idx, 0, helper, error))
+			return FALSE;
+	}
+
+	/* run each shared section once for all the queries */
+	for (guint i = 0; i < node->children->len; i++) {
+		XbSiloQueryBatchNode *child = g_ptr_array_index(node->children, i);
+		g_autoptr(GPtrArray) candidates = NULL;
+
+		if (child->section->kind == XB_SILO_QUERY_KIND_PARENT) {
+			XbSiloNode *parent;
+			if (sn == NULL) {
+				g_set_error_literal(error,
+						    G_IO_ERROR,
+						    G_IO_ERROR_INVALID_ARGUMENT,
+						    "cannot obtain parent for root");
+				return FALSE;
+			}
+			parent = xb_silo_get_parent_node(self, sn);
+			if (parent == NULL) {
+				g_set_error(error,
+					    G_IO_ERROR,
+					    G_IO_ERROR_INVALID_ARGUMENT,
+					    "no parent set for %s",
+					    xb_silo_get_node_element(self, sn));
+				return FALSE;
+			}
+			candidates = g_ptr_array_new();
+			g_ptr_array_add(candidates, parent);
+		} else {
+			candidates = xb_silo_query_section_candidates(self, sn, child->section);
+		}
+
+		query_data->position = 0;
+		for (guint j = 0; j < candidates->len; j++) {
+			XbSiloNode *c = g_ptr_array_index(candidates, j);
+			gboolean result = TRUE;
+			guint position;
+
+			/* the node is visited for every query sharing the section */
+			for (guint k = 0; k < child->queries->len; k++) {
+				XbSiloQueryHelper *helper =
+				    &helpers[g_array_index(child->queries, guint, k)];
+				if (helper->budget == NULL || xb_silo_query_batch_is_done(helper))
+					continue;
+				if (!xb_silo_query_budget_check(helper->budget, error))
+					return FALSE;
+			}
+			if (child->section->kind != XB_SILO_QUERY_KIND_PARENT) {
+				query_data->sn = c;
+				if (!xb_silo_query_node_matches(self,
+								machine,
+								c,
+								child->section,
+								query_data,
+								NULL,
+								0,
+								NULL,
+								&result,
+								NULL,
+								0,
+								error))
+					return FALSE;
+				if (!result)
+					continue;
+			}
+			for (guint k = 0; k < child->finals->len; k++) {
+				XbSiloQueryHelper *helper =
+				    &helpers[g_array_index(child->finals, guint, k)];
+				if (!xb_silo_query_batch_is_done(helper))
+					xb_silo_query_section_add_result(self, helper, c);
+			}
+			position = query_data->position;
+			if (!xb_silo_query_batch_walk(self, child, c, helpers, query_data, error))
+				return FALSE;
+			query_data->position = position;
+		}
+	}
+	return TRUE;
+}
+
+/* runs all the parts of an 'or' search in one walk of the silo, sharing any
+ * leading sections the parts have in common; the results of each part are kept
+ * apart so they can be added to @results in the order of the parts */
+static gboolean
+xb_silo_query_union(XbSilo *self,
+		    XbSiloNode *sroot,
+		    GPtrArray *queries,
+		    GPtrArray *results,
+		    XbSiloQueryHelperFlags flags,
+		    GError **error)
+{
+	g_autoptr(XbSiloQueryBatchNode) root = xb_silo_query_batch_node_new(NULL, NULL, 0);
+	g_autofree XbSiloQueryHelper *helpers = g_new0(XbSiloQueryHelper, queries->len);
+	g_autofree XbSiloQueryData *query_data = g_new0(XbSiloQueryData, queries->len);
+	g_auto(XbSiloQuerySeen) seen = {NULL};
+	XbSiloQueryHelper helper = {
+	    .results = results,
+	    .seen = &seen,
+	    .flags = flags,
+	};
+	g_auto(XbSiloQueryData) query_data_shared = {
+	    .sn = NULL,
+	    .position = 0,
+	};
+	gboolean ret;
+
+	for (guint i = 0; i < queries->len; i++) {
+		XbQuery *query = g_ptr_array_index(queries, i);
+		helpers[i].results = g_ptr_array_new();
+		helpers[i].sections = xb_query_get_sections(query);
+		helpers[i].query_data = &query_data[i];
+		helpers[i].flags = XB_SILO_QUERY_HELPER_USE_SN;
+		if (xb_query_get_never_matches(query))
+			continue;
+		xb_silo_query_batch_node_add(root, helpers[i].sections, i);
+	}
+	ret = xb_silo_query_batch_walk(self, root, sroot, helpers, &query_data_shared, error);
+
+	/* deduplicate once, in the order of the parts */
+	for (guint i = 0; i < queries->len; i++) {
+		for (guint j = 0; ret && j < helpers[i].results->len; j++)
+			xb_silo_query_section_add_result(self,
+							 &helper,
+							 g_ptr_array_index(helpers[i].results, j));
+		g_ptr_array_unref(helpers[i].results);
+		xb_silo_query_data_clear(&query_data[i]);
+	}
+	return ret;
+}
+
+/**
+ * xb_silo_query_batch:
+ * @self: a #XbSilo
+ * @queries: (element-type XbQuery): queries
+ * @contexts: (element-type XbQueryContext) (nullable): contexts for each of
+ *    @queries, or %NULL if the queries do not need any context
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using several XPath queries at once. Any sections at the
+ * start of the queries that are the same are only run once, so this is quicker
+ * than running each query in turn when they share a common prefix.
+ *
+ * Sections that use bound values cannot be shared, so the rest of that query
+ * is run on its own.
+ *
+ * Any cancellable, timeout or node budget set in @contexts is respected, and a
+ * node in a shared section counts as a visit for each query. If any of the
+ * queries is cancelled or runs out of time or nodes then the whole batch fails,
+ * even if %XB_QUERY_FLAG_ALLOW_PARTIAL is set.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbSilo.
+ *
+ * Returns: (transfer container) (element-type GPtrArray): the results for
+ *    each of @queries, each of which may be empty, or %NULL for error
+ *
+ * Since: 0.3.11
+ **/
+GPtrArray *
+xb_silo_query_batch(XbSilo *self, GPtrArray *queries, GPtrArray *contexts, GError **error)
+{
+	g_autoptr(GPtrArray) results_all = NULL;
+	g_autoptr(XbSiloQueryBatchNode) root = xb_silo_query_batch_node_new(NULL, NULL, 0);
+	g_autofree XbSiloQueryHelper *helpers = NULL;
+	g_autofree XbValueBindings *bindings_indexed = NULL;
+	g_autofree XbSiloQuerySeen *seen = NULL;
+	g_autofree XbSiloQueryData *query_data = NULL;
+	g_autofree XbSiloQueryBudget *budgets = NULL;
+	g_autoptr(GTimer) timer = xb_silo_start_profile(self);
+	g_auto(XbSiloQueryData) query_data_shared = {
+	    .sn = NULL,
+	    .position = 0,
+	};
+	gboolean ret;
+
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(queries != NULL, NULL);
+	g_return_val_if_fail(contexts == NULL || contexts->len == queries->len, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	/* empty silo */
+	if (xb_silo_is_empty(self)) {
+		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "silo has no data");
+		return NULL;
+	}
+
+	/* set up each query */
+	results_all = g_ptr_array_new_with_free_func((GDestroyNotify)g_ptr_array_unref);
+	helpers = g_new0(XbSiloQueryHelper, queries->len);
+	bindings_indexed = g_new0(XbValueBindings, queries->len);
+	seen = g_new0(XbSiloQuerySeen, queries->len);
+	query_data = g_new0(XbSiloQueryData, queries->len);
+	budgets = g_new0(XbSiloQueryBudget, queries->len);
+	for (guint i = 0; i < queries->len; i++) {
+		XbQuery *query = g_ptr_array_index(queries, i);
+		XbQueryContext *context = contexts != NULL ? g_ptr_array_index(contexts, i) : NULL;
+		XbSiloQueryHelper *helper = &helpers[i];
+		G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+		XbQueryFlags query_flags = (context != NULL) ? xb_query_context_get_flags(context)
+							     : xb_query_get_flags(query);
+		G_GNUC_END_IGNORE_DEPRECATIONS
+
+		helper->results = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+		g_ptr_array_add(results_all, helper->results);
+		helper->sections = xb_query_get_sections(query);
+		G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+		helper->limit = (context != NULL) ? xb_query_context_get_limit(context)
+						  : xb_query_get_limit(query);
+		G_GNUC_END_IGNORE_DEPRECATIONS
+		helper->query_data = &query_data[i];
+		if (xb_query_get_may_repeat(query))
+			helper->seen = &seen[i];
+		if (query_flags & XB_QUERY_FLAG_FORCE_NODE_CACHE)
+			helper->flags |= XB_SILO_QUERY_HELPER_FORCE_NODE_CACHE;
+		xb_value_bindings_init(&bindings_indexed[i]);
+		if (context != NULL && xb_silo_query_budget_init(&budgets[i], context))
+			helper->budget = &budgets[i];
+		if (context != NULL) {
+			helper->bindings = &bindings_indexed[i];
+			if (!xb_silo_query_intern_bindings(self,
+							   query,
+							   xb_query_context_get_bindings(context),
+							   helper->bindings))
+				continue;
+		}
+
+		/* a literal or element name is not in the strtab */
+		if (xb_query_get_never_matches(query))
+			continue;
+		xb_silo_query_batch_node_add(root, helper->sections, i);
+	}
+
+	/* walk the silo once */
+	ret = xb_silo_query_batch_walk(self, root, NULL, helpers, &query_data_shared, error);
+	for (guint i = 0; i < queries->len; i++) {
+		xb_value_bindings_clear(&bindings_indexed[i]);
+		xb_silo_query_seen_clear(&seen[i]);
+		xb_silo_query_data_clear(&query_data[i]);
+	}
+	if (!ret)
+		return NULL;
+
+	/* reverse order */
+	for (guint i = 0; i < queries->len; i++) {
+		XbQuery *query = g_ptr_array_index(queries, i);
+		XbQueryContext *context = contexts != NULL ? g_ptr_array_index(contexts, i) : NULL;
+		G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+		XbQueryFlags query_flags = (context != NULL) ? xb_query_context_get_flags(context)
+							     : xb_query_get_flags(query);
+		G_GNUC_END_IGNORE_DEPRECATIONS
+		if ((query_flags & XB_QUERY_FLAG_REVERSE) && helpers[i].results->len > 0)
+			_g_ptr_array_reverse(helpers[i].results);
+	}
+
+	/* profile */
+	if (xb_silo_get_profile_flags(self) & XB_SILO_PROFILE_FLAG_XPATH)
+		xb_silo_add_profile(self, timer, "batch of %u queries", queries->len);
+
+	return g_steal_pointer(&results_all);
+}
+
 /**
  * xb_silo_query:
  * @self: a #XbSilo
@@ -725,6 +2195,9 @@ xb_silo_query_first(XbSilo *self, const gchar *xpath, GError **error)
  *
  * Adds the `attr()` or `text()` results of a query to the index.
  *
+ * Since 0.3.11 every string in the silo is indexed automatically when it is
+ * first needed, and so calling this function is no longer required.
+ *
  * Returns: %TRUE for success
  *
  * Since: 0.1.4
@@ -770,3 +2243,751 @@ xb_silo_query_build_index(XbSilo *self, const gchar *xpath, const gchar *attr, G
 	/* success */
 	return TRUE;
 }
+
+/**
+ * XbSiloQueryIter:
+ *
+ * A #XbSiloQueryIter structure represents an iterator that can be used
+ * to lazily get the results of a #XbQuery, in the same order as
+ * xb_silo_query_with_context() would return them. #XbSiloQueryIter
+ * structures are typically allocated on the stack and then initialized
+ * with xb_silo_query_iter_init().
+ *
+ * No objects are allocated for each result unless requested, and the
+ * query stops as soon as the caller stops calling xb_silo_query_iter_next().
+ *
+ * Since: 0.3.11
+ */
+
+typedef struct {
+	XbSiloNode *sn;		/* next candidate, or %NULL when done */
+	guint32 off_end;	/* for the descendant axis, otherwise unused */
+	guint bindings_offset;	/* of the first binding used by the section */
+	guint position;
+} XbSiloQueryIterLevel;
+
+typedef struct {
+	GPtrArray *sections; /* of XbQuerySection */
+	XbValueBindings *bindings;
+	XbValueBindings bindings_indexed;
+	XbSiloQuerySeen seen;
+	gboolean may_repeat;
+	XbSiloQueryData query_data;
+	XbSiloQueryBudget budget; /* the cancellable is owned */
+	gboolean use_budget;
+	gint depth; /* -1 before the first result */
+	gboolean done;
+	XbSiloQueryIterLevel levels[];
+} XbSiloQueryIterState;
+
+typedef struct {
+	XbSilo *silo;
+	XbQuery *query;
+	XbSiloQueryIterState *state;
+	guint limit;
+	guint n_results;
+	XbQueryFlags flags;
+	XbSiloNode *sn;
+	gpointer dummy8;
+} RealSiloQueryIter;
+
+G_STATIC_ASSERT(sizeof(XbSiloQueryIter) == sizeof(RealSiloQueryIter));
+
+/**
+ * xb_silo_query_iter_init:
+ * @iter: an uninitialized #XbSiloQueryIter
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ *
+ * Initializes a query iterator. The results are found as they are requested
+ * using xb_silo_query_iter_next(), and the iterator must be cleared using
+ * xb_silo_query_iter_clear() when finished with.
+ *
+ * %XB_QUERY_FLAG_REVERSE is not supported, as results are produced in order,
+ * and %XB_QUERY_FLAG_PARALLEL and any order set in @context are ignored.
+ *
+ * Any cancellable, timeout or node budget set in @context applies to all the
+ * calls to xb_silo_query_iter_next(), and the timeout starts when the iterator
+ * is initialized. If %XB_QUERY_FLAG_ALLOW_PARTIAL is set then running out of
+ * time or nodes ends the results without an error.
+ *
+ * |[<!-- language="C" -->
+ * g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT ();
+ * xb_silo_query_iter_init (&iter, silo, query, NULL);
+ * while (xb_silo_query_iter_next (&iter, NULL, &error)) {
+ *   g_print ("%s\n", xb_silo_query_iter_get_text (&iter));
+ * }
+ * ]|
+ *
+ * Since: 0.3.11
+ */
+void
+xb_silo_query_iter_init(XbSiloQueryIter *iter,
+			XbSilo *self,
+			XbQuery *query,
+			XbQueryContext *context)
+{
+	RealSiloQueryIter *ri = (RealSiloQueryIter *)iter;
+	XbSiloQueryIterState *state;
+	GPtrArray *sections;
+	g_autoptr(XbQuery) specialized = NULL;
+
+	g_return_if_fail(iter != NULL);
+	g_return_if_fail(XB_IS_SILO(self));
+	g_return_if_fail(XB_IS_QUERY(query));
+
+	/* use a copy of the query with the bound values as literals */
+	if (context != NULL && !xb_query_get_never_matches(query)) {
+		specialized =
+		    xb_query_get_specialized(query, self, xb_query_context_get_bindings(context));
+		if (specialized != NULL)
+			query = specialized;
+	}
+
+	sections = xb_query_get_sections(query);
+	state = g_malloc0(sizeof(XbSiloQueryIterState) +
+			  sections->len * sizeof(XbSiloQueryIterLevel));
+	state->sections = sections;
+	state->may_repeat = xb_query_get_may_repeat(query);
+	state->depth = -1;
+	xb_value_bindings_init(&state->bindings_indexed);
+	if (context != NULL && xb_silo_query_budget_init(&state->budget, context)) {
+		if (state->budget.cancellable != NULL)
+			g_object_ref(state->budget.cancellable);
+		state->use_budget = TRUE;
+	}
+
+	ri->silo = g_object_ref(self);
+	ri->query = g_object_ref(query);
+	ri->state = state;
+	ri->n_results = 0;
+	ri->sn = NULL;
+	ri->dummy8 = NULL;
+
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	ri->limit = (context != NULL) ? xb_query_context_get_limit(context)
+				      : xb_query_get_limit(query);
+	ri->flags = (context != NULL) ? xb_query_context_get_flags(context)
+				      : xb_query_get_flags(query);
+	G_GNUC_END_IGNORE_DEPRECATIONS
+
+	/* a literal or element name is not in the strtab */
+	if (xb_silo_is_empty(self) || xb_query_get_never_matches(query)) {
+		state->done = TRUE;
+		return;
+	}
+
+	/* intern any bound strings */
+	if (context != NULL && specialized == NULL) {
+		if (!xb_silo_query_intern_bindings(self,
+						   query,
+						   xb_query_context_get_bindings(context),
+						   &state->bindings_indexed)) {
+			state->done = TRUE;
+			return;
+		}
+		state->bindings = &state->bindings_indexed;
+	}
+}
+
+/* returns the first element in the nodetab range, or %NULL */
+static XbSiloNode *
+xb_silo_query_iter_scan(XbSilo *self, guint32 off, guint32 off_end)
+{
+	while (off < off_end) {
+		XbSiloNode *sn = xb_silo_get_node(self, off);
+		if (xb_silo_node_has_flag(sn, XB_SILO_NODE_FLAG_IS_ELEMENT))
+			return sn;
+		off += xb_silo_node_get_size(sn);
+	}
+	return NULL;
+}
+
+static gboolean
+xb_silo_query_iter_level_init(RealSiloQueryIter *ri,
+			      guint i,
+			      XbSiloNode *parent,
+			      guint bindings_offset,
+			      GError **error)
+{
+	XbSiloQueryIterLevel *level = &ri->state->levels[i];
+	XbQuerySection *section = g_ptr_array_index(ri->state->sections, i);
+
+	level->bindings_offset = bindings_offset;
+	level->position = 0;
+
+	/* handle parent */
+	if (section->kind == XB_SILO_QUERY_KIND_PARENT) {
+		if (parent == NULL) {
+			g_set_error_literal(error,
+					    G_IO_ERROR,
+					    G_IO_ERROR_INVALID_ARGUMENT,
+					    "cannot obtain parent for root");
+			return FALSE;
+		}
+		level->sn = xb_silo_get_parent_node(ri->silo, parent);
+		if (level->sn == NULL) {
+			g_set_error(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_INVALID_ARGUMENT,
+				    "no parent set for %s",
+				    xb_silo_get_node_element(ri->silo, parent));
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	/* descendants are contiguous in the nodetab */
+	if (section->axis == XB_SILO_QUERY_AXIS_DESCENDANT) {
+		guint32 off;
+		if (parent == NULL) {
+			off = sizeof(XbSiloHeader);
+			level->off_end = xb_silo_get_strtab(ri->silo);
+		} else {
+			off = xb_silo_get_offset_for_node(ri->silo, parent) +
+			      xb_silo_node_get_size(parent);
+			level->off_end = xb_silo_get_node_subtree_end(ri->silo, parent);
+		}
+		level->sn = xb_silo_query_iter_scan(ri->silo, off, level->off_end);
+		return TRUE;
+	}
+
+	/* no node means root */
+	if (parent == NULL) {
+		level->sn = xb_silo_get_root_node(ri->silo);
+		if (level->sn == NULL) {
+			g_set_error_literal(error,
+					    G_IO_ERROR,
+					    G_IO_ERROR_NOT_FOUND,
+					    "silo root not found");
+			return FALSE;
+		}
+		return TRUE;
+	}
+	level->sn = xb_silo_get_child_node(ri->silo, parent);
+	return TRUE;
+}
+
+/* returns the next candidate for the section, or %NULL */
+static XbSiloNode *
+xb_silo_query_iter_level_next(RealSiloQueryIter *ri, guint i)
+{
+	XbSiloQueryIterLevel *level = &ri->state->levels[i];
+	XbQuerySection *section = g_ptr_array_index(ri->state->sections, i);
+	XbSiloNode *sn = level->sn;
+
+	if (sn == NULL)
+		return NULL;
+	if (section->kind == XB_SILO_QUERY_KIND_PARENT) {
+		level->sn = NULL;
+	} else if (section->axis == XB_SILO_QUERY_AXIS_DESCENDANT) {
+		guint32 off = xb_silo_get_offset_for_node(ri->silo, sn);
+		level->sn = xb_silo_query_iter_scan(ri->silo,
+						    off + xb_silo_node_get_size(sn),
+						    level->off_end);
+	} else {
+		level->sn = xb_silo_get_next_node(ri->silo, sn);
+	}
+	return sn;
+}
+
+/**
+ * xb_silo_query_iter_next:
+ * @iter: an initialized #XbSiloQueryIter
+ * @node: (out) (optional) (transfer full) (nullable): Location to store the
+ *    next result, or %NULL
+ * @error: the #GError, or %NULL
+ *
+ * Finds the next result of the query. If @node is %NULL then no object is
+ * created for the result, and xb_silo_query_iter_get_text() or
+ * xb_silo_query_iter_get_attr() can be used to read the result instead.
+ *
+ * Returns: %FALSE if there are no more results or an error occurred, in
+ *    which case @error is set
+ *
+ * Since: 0.3.11
+ */
+gboolean
+xb_silo_query_iter_next(XbSiloQueryIter *iter, XbNode **node, GError **error)
+{
+	RealSiloQueryIter *ri = (RealSiloQueryIter *)iter;
+	XbSiloQueryIterState *state;
+	XbMachine *machine;
+
+	g_return_val_if_fail(iter != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	state = ri->state;
+	ri->sn = NULL;
+	if (state == NULL || state->done)
+		return FALSE;
+	if (ri->limit > 0 && ri->n_results >= ri->limit) {
+		state->done = TRUE;
+		return FALSE;
+	}
+	if (ri->flags & XB_QUERY_FLAG_REVERSE) {
+		state->done = TRUE;
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_NOT_SUPPORTED,
+				    "reverse order is not supported for iterators");
+		return FALSE;
+	}
+
+	/* first section */
+	if (state->depth < 0) {
+		if (!xb_silo_query_iter_level_init(ri, 0, NULL, 0, error)) {
+			state->done = TRUE;
+			return FALSE;
+		}
+		state->depth = 0;
+	}
+
+	machine = xb_silo_get_machine(ri->silo);
+	while (TRUE) {
+		XbSiloQueryIterLevel *level = &state->levels[state->depth];
+		XbQuerySection *section = g_ptr_array_index(state->sections, state->depth);
+		XbSiloNode *sn = xb_silo_query_iter_level_next(ri, state->depth);
+		guint bindings_offset_end = level->bindings_offset;
+
+		/* go back up to the previous section */
+		if (sn == NULL) {
+			if (state->depth == 0) {
+				state->done = TRUE;
+				return FALSE;
+			}
+			state->depth--;
+			continue;
+		}
+
+		/* stop early if cancelled, or out of time or nodes */
+		if (state->use_budget) {
+			g_autoptr(GError) error_local = NULL;
+			if (!xb_silo_query_budget_check(&state->budget, &error_local)) {
+				state->done = TRUE;
+				if (g_error_matches(error_local,
+						    G_IO_ERROR,
+						    G_IO_ERROR_TIMED_OUT) &&
+				    ri->flags & XB_QUERY_FLAG_ALLOW_PARTIAL) {
+					g_debug("returning partial results: %s",
+						error_local->message);
+					return FALSE;
+				}
+				g_propagate_error(error, g_steal_pointer(&error_local));
+				return FALSE;
+			}
+		}
+
+		/* the parent always matches */
+		if (section->kind != XB_SILO_QUERY_KIND_PARENT) {
+			gboolean result = TRUE;
+			state->query_data.sn = sn;
+			state->query_data.position = level->position;
+			if (!xb_silo_query_node_matches(ri->silo,
+							machine,
+							sn,
+							section,
+							&state->query_data,
+							state->bindings,
+							level->bindings_offset,
+							&bindings_offset_end,
+							&result,
+							NULL,
+							0,
+							error)) {
+				state->done = TRUE;
+				return FALSE;
+			}
+			level->position = state->query_data.position;
+			if (!result)
+				continue;
+		}
+
+		/* go down to the next section */
+		if ((guint)state->depth + 1 < state->sections->len) {
+			if (!xb_silo_query_iter_level_init(ri,
+							   state->depth + 1,
+							   sn,
+							   bindings_offset_end,
+							   error)) {
+				state->done = TRUE;
+				return FALSE;
+			}
+			state->depth++;
+			continue;
+		}
+
+		/* already returned */
+		if (state->may_repeat && !xb_silo_query_seen_add(ri->silo, &state->seen, sn))
+			continue;
+
+		/* success */
+		ri->sn = sn;
+		ri->n_results++;
+		if (node != NULL) {
+			*node = xb_silo_create_node(ri->silo,
+						    sn,
+						    (ri->flags & XB_QUERY_FLAG_FORCE_NODE_CACHE) > 0);
+		}
+		return TRUE;
+	}
+}
+
+/**
+ * xb_silo_query_iter_get_text:
+ * @iter: an initialized #XbSiloQueryIter
+ *
+ * Gets the text of the current result without creating a #XbNode.
+ *
+ * Returns: a string, or %NULL if unset
+ *
+ * Since: 0.3.11
+ */
+const gchar *
+xb_silo_query_iter_get_text(XbSiloQueryIter *iter)
+{
+	RealSiloQueryIter *ri = (RealSiloQueryIter *)iter;
+	g_return_val_if_fail(iter != NULL, NULL);
+	if (ri->sn == NULL)
+		return NULL;
+	return xb_silo_get_node_text(ri->silo, ri->sn);
+}
+
+/**
+ * xb_silo_query_iter_get_attr:
+ * @iter: an initialized #XbSiloQueryIter
+ * @name: an attribute name, e.g. `type`
+ *
+ * Gets an attribute of the current result without creating a #XbNode.
+ *
+ * Returns: a string, or %NULL if unset
+ *
+ * Since: 0.3.11
+ */
+const gchar *
+xb_silo_query_iter_get_attr(XbSiloQueryIter *iter, const gchar *name)
+{
+	RealSiloQueryIter *ri = (RealSiloQueryIter *)iter;
+	XbSiloNodeAttr *a;
+
+	g_return_val_if_fail(iter != NULL, NULL);
+	g_return_val_if_fail(name != NULL, NULL);
+
+	if (ri->sn == NULL)
+		return NULL;
+	a = xb_silo_get_node_attr_by_str(ri->silo, ri->sn, name);
+	if (a == NULL)
+		return NULL;
+	return xb_silo_from_strtab(ri->silo, a->attr_value);
+}
+
+/**
+ * xb_silo_query_iter_clear:
+ * @iter: a #XbSiloQueryIter
+ *
+ * Frees any resources used by the iterator. The iterator can be cleared more
+ * than once.
+ *
+ * Since: 0.3.11
+ */
+void
+xb_silo_query_iter_clear(XbSiloQueryIter *iter)
+{
+	RealSiloQueryIter *ri = (RealSiloQueryIter *)iter;
+
+	g_return_if_fail(iter != NULL);
+
+	if (ri->state != NULL) {
+		xb_value_bindings_clear(&ri->state->bindings_indexed);
+		xb_silo_query_seen_clear(&ri->state->seen);
+		xb_silo_query_data_clear(&ri->state->query_data);
+		g_clear_object(&ri->state->budget.cancellable);
+		g_clear_pointer(&ri->state, g_free);
+	}
+	g_clear_object(&ri->query);
+	g_clear_object(&ri->silo);
+	ri->sn = NULL;
+}
+
+/**
+ * xb_silo_query_count:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @error: the #GError, or %NULL
+ *
+ * Counts the results of an XPath query without creating any #XbNode objects.
+ * Any limit, cancellable, timeout or node budget set in @context is respected.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbSilo.
+ *
+ * Returns: number of results, or 0 if there are none or an error occurred
+ *
+ * Since: 0.3.11
+ **/
+guint
+xb_silo_query_count(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error)
+{
+	g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+	g_autoptr(GError) error_local = NULL;
+	guint cnt = 0;
+
+	g_return_val_if_fail(XB_IS_SILO(self), 0);
+	g_return_val_if_fail(XB_IS_QUERY(query), 0);
+	g_return_val_if_fail(error == NULL || *error == NULL, 0);
+
+	/* the order does not matter */
+	xb_silo_query_iter_init(&iter, self, query, context);
+	((RealSiloQueryIter *)&iter)->flags &= ~XB_QUERY_FLAG_REVERSE;
+	while (xb_silo_query_iter_next(&iter, NULL, &error_local))
+		cnt++;
+	if (error_local != NULL) {
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		return 0;
+	}
+	return cnt;
+}
+
+/**
+ * xb_silo_query_exists:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @error: the #GError, or %NULL
+ *
+ * Finds if an XPath query has any results, stopping at the first one and
+ * without creating any #XbNode objects. Any cancellable, timeout or node budget
+ * set in @context is respected.
+ *
+ * It is safe to call this function from a different thread to the one that
+ * created the #XbSilo.
+ *
+ * Returns: %TRUE if there is at least one result
+ *
+ * Since: 0.3.11
+ **/
+gboolean
+xb_silo_query_exists(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error)
+{
+	g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+	g_autoptr(GError) error_local = NULL;
+
+	g_return_val_if_fail(XB_IS_SILO(self), FALSE);
+	g_return_val_if_fail(XB_IS_QUERY(query), FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	/* the order does not matter */
+	xb_silo_query_iter_init(&iter, self, query, context);
+	((RealSiloQueryIter *)&iter)->flags &= ~XB_QUERY_FLAG_REVERSE;
+	if (!xb_silo_query_iter_next(&iter, NULL, &error_local)) {
+		if (error_local != NULL) {
+			g_propagate_error(error, g_steal_pointer(&error_local));
+			return FALSE;
+		}
+		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "no results");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* returns @values, or %NULL if it is empty */
+static GPtrArray *
+xb_silo_query_values_check(XbQuery *query, GPtrArray *values, GError **error)
+{
+	if (values->len == 0) {
+		g_autofree gchar *tmp = xb_query_to_string(query);
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_NOT_FOUND,
+			    "no results for XPath query '%s'",
+			    tmp);
+		g_ptr_array_unref(values);
+		return NULL;
+	}
+	return values;
+}
+
+static const gchar *
+xb_silo_query_value_for_sn(XbSilo *self, XbSiloNode *sn, const gchar *name)
+{
+	XbSiloNodeAttr *a;
+
+	if (name == NULL)
+		return xb_silo_get_node_text(self, sn);
+	a = xb_silo_get_node_attr_by_str(self, sn, name);
+	if (a == NULL)
+		return NULL;
+	return xb_silo_from_strtab(self, a->attr_value);
+}
+
+/* the iterator can only return results in document order, so run the whole
+ * query when they have to be reversed or sorted */
+static gboolean
+xb_silo_query_values_ordered(XbSilo *self,
+			     XbQuery *query,
+			     XbQueryContext *context,
+			     XbQueryFlags query_flags,
+			     const gchar *name,
+			     GPtrArray *values,
+			     GError **error)
+{
+	g_autoptr(GPtrArray) results = g_ptr_array_new();
+	g_auto(XbSiloQuerySeen) seen = {NULL};
+	g_auto(XbSiloQueryData) query_data = {
+	    .sn = NULL,
+	    .position = 0,
+	};
+
+	if (xb_silo_is_empty(self))
+		return TRUE;
+	if (!xb_silo_query_part(self,
+				NULL,
+				results,
+				xb_query_get_may_repeat(query) ? &seen : NULL,
+				query,
+				context,
+				FALSE,
+				&query_data,
+				XB_SILO_QUERY_HELPER_USE_SN,
+				NULL,
+				NULL,
+				error))
+		return FALSE;
+	if (query_flags & XB_QUERY_FLAG_REVERSE)
+		_g_ptr_array_reverse(results);
+	for (guint i = 0; i < results->len; i++) {
+		XbSiloNode *sn = g_ptr_array_index(results, i);
+		const gchar *value = xb_silo_query_value_for_sn(self, sn, name);
+		if (value != NULL)
+			g_ptr_array_add(values, (gpointer)value);
+	}
+	return TRUE;
+}
+
+static GPtrArray *
+xb_silo_query_values(XbSilo *self,
+		     XbQuery *query,
+		     XbQueryContext *context,
+		     const gchar *name,
+		     GError **error)
+{
+	g_auto(XbSiloQueryIter) iter = XB_SILO_QUERY_ITER_INIT();
+	g_autoptr(GError) error_local = NULL;
+	g_autoptr(GPtrArray) values = g_ptr_array_new();
+	G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+	XbQueryFlags query_flags = (context != NULL) ? xb_query_context_get_flags(context)
+						     : xb_query_get_flags(query);
+	G_GNUC_END_IGNORE_DEPRECATIONS
+
+	/* the XPath might say what to return */
+	if (name == NULL)
+		name = xb_query_get_projection_attr(query);
+
+	if (query_flags & XB_QUERY_FLAG_REVERSE ||
+	    (context != NULL && xb_query_context_get_order(context, NULL) != NULL)) {
+		if (!xb_silo_query_values_ordered(self,
+						  query,
+						  context,
+						  query_flags,
+						  name,
+						  values,
+						  error))
+			return NULL;
+		return xb_silo_query_values_check(query, g_steal_pointer(&values), error);
+	}
+
+	xb_silo_query_iter_init(&iter, self, query, context);
+	while (xb_silo_query_iter_next(&iter, NULL, &error_local)) {
+		const gchar *value = (name != NULL) ? xb_silo_query_iter_get_attr(&iter, name)
+						    : xb_silo_query_iter_get_text(&iter);
+		if (value != NULL)
+			g_ptr_array_add(values, (gpointer)value);
+	}
+	if (error_local != NULL) {
+		g_propagate_error(error, g_steal_pointer(&error_local));
+		return NULL;
+	}
+	return xb_silo_query_values_check(query, g_steal_pointer(&values), error);
+}
+
+/**
+ * xb_silo_query_texts:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using an XPath query, returning the text of each result
+ * without creating any #XbNode objects. Results without any text are skipped.
+ *
+ * The XPath may end with `/text()`, or with `/@attr` to return the value of
+ * the attribute `attr` instead.
+ *
+ * Any cancellable, timeout or node budget set in @context is respected. If
+ * %XB_QUERY_FLAG_REVERSE or an order is set in @context then all the results
+ * are found before any strings are returned.
+ *
+ * The strings are owned by @self, so the lifetime of @self must exceed the
+ * lifetime of the returned array.
+ *
+ * Returns: (transfer container) (element-type utf8): strings, or %NULL if unfound
+ *
+ * Since: 0.3.11
+ **/
+GPtrArray *
+xb_silo_query_texts(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error)
+{
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(XB_IS_QUERY(query), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	return xb_silo_query_values(self, query, context, NULL, error);
+}
+
+/**
+ * xb_silo_query_attrs:
+ * @self: a #XbSilo
+ * @query: an #XbQuery
+ * @context: (nullable) (transfer none): context including values bound to opcodes of type
+ *     %XB_OPCODE_KIND_BOUND_INTEGER or %XB_OPCODE_KIND_BOUND_TEXT, or %NULL if
+ *     the query doesn’t need any context
+ * @name: an attribute name, e.g. `version`
+ * @error: the #GError, or %NULL
+ *
+ * Searches the silo using an XPath query, returning the value of the attribute
+ * @name of each result without creating any #XbNode objects. Results without
+ * the attribute are skipped.
+ *
+ * Any cancellable, timeout or node budget set in @context is respected. If
+ * %XB_QUERY_FLAG_REVERSE or an order is set in @context then all the results
+ * are found before any strings are returned.
+ *
+ * The strings are owned by @self, so the lifetime of @self must exceed the
+ * lifetime of the returned array.
+ *
+ * Returns: (transfer container) (element-type utf8): strings, or %NULL if unfound
+ *
+ * Since: 0.3.11
+ **/
+GPtrArray *
+xb_silo_query_attrs(XbSilo *self,
+		    XbQuery *query,
+		    XbQueryContext *context,
+		    const gchar *name,
+		    GError **error)
+{
+	g_return_val_if_fail(XB_IS_SILO(self), NULL);
+	g_return_val_if_fail(XB_IS_QUERY(query), NULL);
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+	return xb_silo_query_values(self, query, context, name, error);
+}
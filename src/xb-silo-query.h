@@ -10,11 +10,54 @@
 
 #include "xb-node.h"
 #include "xb-query-context.h"
+#include "xb-query-profile.h"
 #include "xb-query.h"
 #include "xb-silo.h"
 
 G_BEGIN_DECLS
 
+typedef struct {
+	/*< private >*/
+	gpointer dummy1;
+	gpointer dummy2;
+	gpointer dummy3;
+	guint dummy4;
+	guint dummy5;
+	guint dummy6;
+	gpointer dummy7;
+	gpointer dummy8;
+} XbSiloQueryIter;
+
+/**
+ * XB_SILO_QUERY_ITER_INIT:
+ *
+ * Static initialiser for #XbSiloQueryIter so it can be used on the stack
+ * with g_auto() before xb_silo_query_iter_init() is called.
+ *
+ * Since: 0.3.11
+ */
+#define XB_SILO_QUERY_ITER_INIT()                                                                  \
+	{                                                                                          \
+		NULL, NULL, NULL, 0, 0, 0, NULL, NULL                                              \
+	}
+
+/**
+ * XbSiloSearchFlags:
+ * @XB_SILO_SEARCH_FLAG_NONE:		Add the weight of each field with a match
+ * @XB_SILO_SEARCH_FLAG_BM25:		Add the Okapi BM25 score of each field,
+ *					multiplied by the weight
+ *
+ * The flags used when scoring search results.
+ *
+ * Since: 0.3.11
+ **/
+typedef enum {
+	XB_SILO_SEARCH_FLAG_NONE = 0,	   /* Since: 0.3.11 */
+	XB_SILO_SEARCH_FLAG_BM25 = 1 << 0, /* Since: 0.3.11 */
+	/*< private >*/
+	XB_SILO_SEARCH_FLAG_LAST
+} XbSiloSearchFlags;
+
 GPtrArray *
 xb_silo_query(XbSilo *self, const gchar *xpath, guint limit, GError **error);
 
@@ -22,6 +65,12 @@ GPtrArray *
 xb_silo_query_full(XbSilo *self, XbQuery *query, GError **error);
 GPtrArray *
 xb_silo_query_with_context(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error);
+GPtrArray *
+xb_silo_query_with_profile(XbSilo *self,
+			   XbQuery *query,
+			   XbQueryContext *context,
+			   XbQueryProfile **profile,
+			   GError **error);
 
 XbNode *
 xb_silo_query_first(XbSilo *self, const gchar *xpath, GError **error);
@@ -34,7 +83,51 @@ xb_silo_query_first_with_context(XbSilo *self,
 				 XbQueryContext *context,
 				 GError **error);
 
+guint
+xb_silo_query_count(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error);
+gboolean
+xb_silo_query_exists(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error);
+
+GPtrArray *
+xb_silo_query_texts(XbSilo *self, XbQuery *query, XbQueryContext *context, GError **error);
+GPtrArray *
+xb_silo_query_attrs(XbSilo *self,
+		    XbQuery *query,
+		    XbQueryContext *context,
+		    const gchar *name,
+		    GError **error);
+
+GPtrArray *
+xb_silo_query_search(XbSilo *self,
+		     XbQuery *query,
+		     XbQueryContext *context,
+		     const gchar *search,
+		     const gchar *const *fields,
+		     const guint *weights,
+		     guint weights_len,
+		     XbSiloSearchFlags flags,
+		     GError **error);
+
+GPtrArray *
+xb_silo_query_batch(XbSilo *self, GPtrArray *queries, GPtrArray *contexts, GError **error);
+
 gboolean
 xb_silo_query_build_index(XbSilo *self, const gchar *xpath, const gchar *attr, GError **error);
 
+void
+xb_silo_query_iter_init(XbSiloQueryIter *iter,
+			XbSilo *self,
+			XbQuery *query,
+			XbQueryContext *context);
+gboolean
+xb_silo_query_iter_next(XbSiloQueryIter *iter, XbNode **node, GError **error);
+const gchar *
+xb_silo_query_iter_get_text(XbSiloQueryIter *iter);
+const gchar *
+xb_silo_query_iter_get_attr(XbSiloQueryIter *iter, const gchar *name);
+void
+xb_silo_query_iter_clear(XbSiloQueryIter *iter);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(XbSiloQueryIter, xb_silo_query_iter_clear)
+
 G_END_DECLS
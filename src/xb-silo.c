@@ -30,10 +30,6 @@
 #include <glib-object.h>
 #include <string.h>
 
-#ifdef HAVE_LIBSTEMMER
-#include <libstemmer.h>
-#endif
-
 #include "xb-builder.h"
 #include "xb-common-private.h"
 #include "xb-machine-private.h"
@@ -43,6 +39,9 @@
 #include "xb-stack-private.h"
 #include "xb-string-private.h"
 
+/* the number of tokenized search strings kept for each kind of search */
+#define XB_SILO_SEARCH_CACHE_MAX 64
+
 typedef struct {
 	GMappedFile *mmap;
 	gchar *guid;
@@ -51,8 +50,20 @@ typedef struct {
 	const guint8 *data; /* pointers into ->blob */
 	guint32 datasz;
 	guint32 strtab;
+	guint32 strtab_tokens;
+	guint32 tokentab;
+	guint32 foldtab;
+	XbSiloHeaderFlags flags;
 	GHashTable *strtab_tags;
-	GHashTable *strindex;
+	GHashTable *strindex; /* (mutex strindex_mutex) */
+	gboolean strindex_complete;
+	GMutex strindex_mutex;
+	GHashTable *stats_elements; /* (mutex stats_mutex): element_idx to count */
+	GHashTable *stats_values;   /* (mutex stats_mutex): key to (value_idx to count) */
+	GArray *tokens;		    /* (mutex stats_mutex): of guint32 strtab offsets */
+	GHashTable *fuzzy_tokens;   /* (mutex stats_mutex): key to XbSiloFuzzyTokens */
+	GHashTable *search_tokens;  /* (mutex stats_mutex): search to XbSiloSearchTokens */
+	GMutex stats_mutex;
 	gboolean enable_node_cache;
 	GHashTable *nodes; /* (mutex nodes_mutex) */
 	GMutex nodes_mutex;
@@ -65,10 +76,6 @@ typedef struct {
 	GRWLock query_cache_mutex;
 	GHashTable *query_cache;
 	GMainContext *context; /* (owned) */
-#ifdef HAVE_LIBSTEMMER
-	struct sb_stemmer *stemmer_ctx; /* lazy loaded */
-	GMutex stemmer_mutex;
-#endif
 } XbSiloPrivate;
 
 typedef struct {
@@ -140,39 +147,6 @@ xb_silo_add_profile(XbSilo *self, GTimer *timer, const gchar *fmt, ...)
 		g_timer_reset(timer);
 }
 
-/* private */
-static gchar *
-xb_silo_stem(XbSilo *self, const gchar *value)
-{
-#ifdef HAVE_LIBSTEMMER
-	XbSiloPrivate *priv = GET_PRIVATE(self);
-	const gchar *tmp;
-	gsize len_dst;
-	gsize len_src;
-	g_autofree gchar *value_casefold = NULL;
-	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stemmer_mutex);
-
-	g_return_val_if_fail(locker != NULL, NULL);
-
-	/* not enabled */
-	value_casefold = g_utf8_casefold(value, -1);
-	if (priv->stemmer_ctx == NULL)
-		priv->stemmer_ctx = sb_stemmer_new("en", NULL);
-
-	/* stem */
-	len_src = strlen(value_casefold);
-	tmp = (const gchar *)sb_stemmer_stem(priv->stemmer_ctx,
-					     (guchar *)value_casefold,
-					     (gint)len_src);
-	len_dst = (gsize)sb_stemmer_length(priv->stemmer_ctx);
-	if (len_src == len_dst)
-		return g_steal_pointer(&value_casefold);
-	return g_strndup(tmp, len_dst);
-#else
-	return g_utf8_casefold(value, -1);
-#endif
-}
-
 /* private */
 const gchar *
 xb_silo_from_strtab(XbSilo *self, guint32 offset)
@@ -180,7 +154,7 @@ xb_silo_from_strtab(XbSilo *self, guint32 offset)
 	XbSiloPrivate *priv = GET_PRIVATE(self);
 	if (offset == XB_SILO_UNSET)
 		return NULL;
-	if (offset >= priv->datasz - priv->strtab) {
+	if (offset >= priv->tokentab - priv->strtab) {
 		g_critical("strtab+offset is outside the data range for %u", offset);
 		return NULL;
 	}
@@ -193,22 +167,523 @@ xb_silo_strtab_index_insert(XbSilo *self, guint32 offset)
 {
 	XbSiloPrivate *priv = GET_PRIVATE(self);
 	const gchar *tmp;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->strindex_mutex);
 
 	/* get the string version */
 	tmp = xb_silo_from_strtab(self, offset);
 	if (tmp == NULL)
 		return;
-	if (g_hash_table_lookup(priv->strindex, tmp) != NULL)
+	if (g_hash_table_contains(priv->strindex, tmp))
 		return;
 	g_hash_table_insert(priv->strindex, (gpointer)tmp, GUINT_TO_POINTER(offset));
 }
 
+/* the builder deduplicates every string before the sorted tokens at the end of
+ * the strtab, but a token may repeat one of them; the index keeps the first
+ * offset, which is the one used by the nodes */
+static void
+xb_silo_strtab_index_ensure(XbSilo *self)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	guint32 strtabsz;
+	guint32 off = 0;
+	g_autoptr(GTimer) timer = NULL;
+
+	if (priv->strindex_complete || priv->data == NULL || priv->strtab > priv->datasz)
+		return;
+
+	timer = xb_silo_start_profile(self);
+	strtabsz = priv->tokentab - priv->strtab;
+	while (off < strtabsz) {
+		const gchar *tmp = (const gchar *)(priv->data + priv->strtab + off);
+		const gchar *nul = memchr(tmp, '\0', strtabsz - off);
+		if (nul == NULL)
+			break;
+		if (!g_hash_table_contains(priv->strindex, tmp))
+			g_hash_table_insert(priv->strindex, (gpointer)tmp, GUINT_TO_POINTER(off));
+		off += (nul - tmp) + 1;
+	}
+	priv->strindex_complete = TRUE;
+	xb_silo_add_profile(self, timer, "index strtab");
+}
+
+/* private: the number of elements called @element_idx, counted for all the
+ * elements when first used */
+guint
+xb_silo_get_element_count(XbSilo *self, guint32 element_idx)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stats_mutex);
+
+	if (priv->stats_elements == NULL) {
+		g_autoptr(GTimer) timer = xb_silo_start_profile(self);
+		priv->stats_elements = g_hash_table_new(g_direct_hash, g_direct_equal);
+		for (guint32 off = sizeof(XbSiloHeader); off < priv->strtab;) {
+			XbSiloNode *sn = xb_silo_get_node(self, off);
+			if (xb_silo_node_has_flag(sn, XB_SILO_NODE_FLAG_IS_ELEMENT)) {
+				gpointer key = GUINT_TO_POINTER(sn->element_name);
+				guint cnt = GPOINTER_TO_UINT(
+				    g_hash_table_lookup(priv->stats_elements, key));
+				g_hash_table_insert(priv->stats_elements,
+						    key,
+						    GUINT_TO_POINTER(cnt + 1));
+			}
+			off += xb_silo_node_get_size(sn);
+		}
+		xb_silo_add_profile(self, timer, "count elements");
+	}
+	return GPOINTER_TO_UINT(
+	    g_hash_table_lookup(priv->stats_elements, GUINT_TO_POINTER(element_idx)));
+}
+
+/* private: the number of elements called @element_idx where the attribute
+ * @attr, or the text if %NULL, is @value_idx; the values are counted for each
+ * element and attribute when first used */
+guint
+xb_silo_get_value_count(XbSilo *self, guint32 element_idx, const gchar *attr, guint32 value_idx)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	GHashTable *values;
+	g_autofree gchar *key = g_strdup_printf("%u:%s", element_idx, attr != NULL ? attr : "");
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stats_mutex);
+
+	if (priv->stats_values == NULL) {
+		priv->stats_values = g_hash_table_new_full(g_str_hash,
+							   g_str_equal,
+							   g_free,
+							   (GDestroyNotify)g_hash_table_unref);
+	}
+	values = g_hash_table_lookup(priv->stats_values, key);
+	if (values == NULL) {
+		g_autoptr(GTimer) timer = xb_silo_start_profile(self);
+		values = g_hash_table_new(g_direct_hash, g_direct_equal);
+		for (guint32 off = sizeof(XbSiloHeader); off < priv->strtab;) {
+			XbSiloNode *sn = xb_silo_get_node(self, off);
+			guint32 idx = XB_SILO_UNSET;
+			off += xb_silo_node_get_size(sn);
+			if (!xb_silo_node_has_flag(sn, XB_SILO_NODE_FLAG_IS_ELEMENT) ||
+			    sn->element_name != element_idx)
+				continue;
+			if (attr != NULL) {
+				XbSiloNodeAttr *a = xb_silo_get_node_attr_by_str(self, sn, attr);
+				if (a != NULL)
+					idx = a->attr_value;
+			} else {
+				idx = xb_silo_node_get_text_idx(sn);
+			}
+			if (idx != XB_SILO_UNSET) {
+				guint cnt = GPOINTER_TO_UINT(
+				    g_hash_table_lookup(values, GUINT_TO_POINTER(idx)));
+				g_hash_table_insert(values,
+						    GUINT_TO_POINTER(idx),
+						    GUINT_TO_POINTER(cnt + 1));
+			}
+		}
+		g_hash_table_insert(priv->stats_values, g_steal_pointer(&key), values);
+		xb_silo_add_profile(self,
+				    timer,
+				    "count values of %s",
+				    attr != NULL ? attr : "text()");
+	}
+	return GPOINTER_TO_UINT(g_hash_table_lookup(values, GUINT_TO_POINTER(value_idx)));
+}
+
+/* the offsets of the sorted tokens at the end of the strtab, found when first used */
+static GArray *
+xb_silo_get_tokens(XbSilo *self)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stats_mutex);
+
+	if (priv->tokens == NULL) {
+		guint32 strtabsz = priv->tokentab - priv->strtab;
+		priv->tokens = g_array_new(FALSE, FALSE, sizeof(guint32));
+		for (guint32 off = priv->strtab_tokens; off < strtabsz;) {
+			const gchar *tmp = (const gchar *)(priv->data + priv->strtab + off);
+			g_array_append_val(priv->tokens, off);
+			off += strnlen(tmp, strtabsz - off) + 1;
+		}
+	}
+	return priv->tokens;
+}
+
+/* private: sets @lo and @hi to the range of addresses of the tokens in the
+ * strtab which start with @prefix, so a token from a node can be checked
+ * without comparing strings; returns %FALSE if there are no such tokens */
+gboolean
+xb_silo_get_token_range(XbSilo *self, const gchar *prefix, const gchar **lo, const gchar **hi)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	GArray *tokens = xb_silo_get_tokens(self);
+	const gchar *strtab = (const gchar *)(priv->data + priv->strtab);
+	gsize prefix_len = strlen(prefix);
+	guint32 *offs = (guint32 *)tokens->data;
+	guint l = 0;
+	guint r = tokens->len;
+	guint lo_idx;
+
+	/* the first token that sorts after @prefix */
+	while (l < r) {
+		guint m = l + (r - l) / 2;
+		if (strcmp(strtab + offs[m], prefix) < 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	lo_idx = l;
+
+	/* the first token after that which does not start with @prefix */
+	r = tokens->len;
+	while (l < r) {
+		guint m = l + (r - l) / 2;
+		if (strncmp(strtab + offs[m], prefix, prefix_len) == 0)
+			l = m + 1;
+		else
+			r = m;
+	}
+	if (l == lo_idx)
+		return FALSE;
+	*lo = strtab + offs[lo_idx];
+	*hi = l < tokens->len ? strtab + offs[l] : strtab + (priv->tokentab - priv->strtab);
+	return TRUE;
+}
+
+/* private: if @token is one of the sorted tokens in the strtab */
+gboolean
+xb_silo_is_token(XbSilo *self, const gchar *token)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	const gchar *strtab = (const gchar *)(priv->data + priv->strtab);
+	return token >= strtab + priv->strtab_tokens &&
+	       token < strtab + (priv->tokentab - priv->strtab);
+}
+
+static guint32
+xb_silo_get_tokentab_value(XbSilo *self, guint idx)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	guint32 val;
+
+	if (idx >= (priv->foldtab - priv->tokentab) / sizeof(guint32))
+		return 0;
+
+	/* the tokentab follows the strtab, so is not aligned */
+	memcpy(&val, priv->data + priv->tokentab + idx * sizeof(guint32), sizeof(val));
+	return val;
+}
+
+/* private: the number of tokenized nodes that have @token, which must be one
+ * of the sorted tokens in the strtab */
+guint32
+xb_silo_get_token_frequency(XbSilo *self, const gchar *token)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	GArray *tokens = xb_silo_get_tokens(self);
+	guint32 off = token - (const gchar *)(priv->data + priv->strtab);
+	guint32 *offs = (guint32 *)tokens->data;
+	guint l = 0;
+	guint r = tokens->len;
+
+	while (l < r) {
+		guint m = l + (r - l) / 2;
+		if (offs[m] < off)
+			l = m + 1;
+		else
+			r = m;
+	}
+	if (l == tokens->len || offs[l] != off)
+		return 0;
+	return xb_silo_get_tokentab_value(self, XB_SILO_TOKENTAB_DF + l);
+}
+
+/* private */
+void
+xb_silo_fuzzy_tokens_unref(XbSiloFuzzyTokens *fuzzy)
+{
+	if (!g_atomic_int_dec_and_test(&fuzzy->ref))
+		return;
+	g_free(fuzzy->search);
+	g_array_unref(fuzzy->tokens);
+	g_free(fuzzy);
+}
+
+static gint
+xb_silo_fuzzy_tokens_sort_cb(gconstpointer a, gconstpointer b)
+{
+	const gchar *token1 = *(const gchar **)a;
+	const gchar *token2 = *(const gchar **)b;
+	return (token1 > token2) - (token1 < token2);
+}
+
+/* the sorted tokens are walked like a trie: the rows of edit distances for the
+ * prefix shared with the previous token are reused, and once every entry in a
+ * row is too large all the tokens starting with that prefix are skipped */
+static void
+xb_silo_add_fuzzy_tokens(XbSilo *self,
+			 GArray *tokens,
+			 const gchar *search,
+			 guint max_dist,
+			 GArray *matches)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	const gchar *strtab = (const gchar *)(priv->data + priv->strtab);
+	const gchar *token_prev = "";
+	guint32 *offs = (guint32 *)tokens->data;
+	guint depth_prev = 0;
+	glong search_len = 0;
+	gsize stride;
+	g_autofree gunichar *search_ucs4 = g_utf8_to_ucs4_fast(search, -1, &search_len);
+	g_autoptr(GArray) rows = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	/* distances from the empty prefix */
+	stride = search_len + 1;
+	g_array_set_size(rows, stride);
+	for (gsize j = 0; j < stride; j++)
+		g_array_index(rows, guint, j) = j;
+
+	for (guint i = 0; i < tokens->len; i++) {
+		const gchar *token = strtab + offs[i];
+		const gchar *tmp = token;
+		const gchar *tmp_prev = token_prev;
+		guint depth = 0;
+		gboolean too_far = FALSE;
+		gsize prefix_len;
+		guint l;
+		guint r;
+
+		/* skip the shared prefix */
+		while (depth < depth_prev && *tmp != '\0' &&
+		       g_utf8_get_char(tmp) == g_utf8_get_char(tmp_prev)) {
+			tmp = g_utf8_next_char(tmp);
+			tmp_prev = g_utf8_next_char(tmp_prev);
+			depth++;
+		}
+
+		/* add a row for each remaining character */
+		for (; *tmp != '\0'; tmp = g_utf8_next_char(tmp)) {
+			guint *row;
+			g_array_set_size(rows, (depth + 2) * stride);
+			row = &g_array_index(rows, guint, (depth + 1) * stride);
+			if (xb_string_levenshtein_row(search_ucs4,
+						      search_len,
+						      row - stride,
+						      row,
+						      g_utf8_get_char(tmp)) > max_dist) {
+				too_far = TRUE;
+				break;
+			}
+			depth++;
+		}
+		token_prev = token;
+		depth_prev = depth;
+		if (!too_far) {
+			if (g_array_index(rows, guint, depth * stride + search_len) <= max_dist)
+				g_array_append_val(matches, token);
+			continue;
+		}
+
+		/* the tokens with the same prefix follow this one */
+		prefix_len = g_utf8_next_char(tmp) - token;
+		l = i + 1;
+		r = tokens->len;
+		while (l < r) {
+			guint m = l + (r - l) / 2;
+			if (strncmp(strtab + offs[m], token, prefix_len) == 0)
+				l = m + 1;
+			else
+				r = m;
+		}
+		i = l - 1;
+	}
+}
+
+/* private: the sorted tokens within @max_dist edits of any token of @search,
+ * found when first used, with the most recent ones kept until the silo is
+ * reloaded */
+XbSiloFuzzyTokens *
+xb_silo_get_fuzzy_tokens(XbSilo *self, const gchar *search, guint max_dist)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	GArray *tokens = xb_silo_get_tokens(self);
+	XbSiloFuzzyTokens *fuzzy;
+	g_autofree gchar *key = g_strdup_printf("%u:%s", max_dist, search);
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stats_mutex);
+	g_auto(GStrv) search_tokens = NULL;
+	g_auto(GStrv) search_ascii_tokens = NULL;
+	guint j = 0;
+
+	if (priv->fuzzy_tokens == NULL) {
+		priv->fuzzy_tokens =
+		    g_hash_table_new_full(g_str_hash,
+					  g_str_equal,
+					  g_free,
+					  (GDestroyNotify)xb_silo_fuzzy_tokens_unref);
+	}
+	fuzzy = g_hash_table_lookup(priv->fuzzy_tokens, key);
+	if (fuzzy != NULL) {
+		g_atomic_int_inc(&fuzzy->ref);
+		return fuzzy;
+	}
+
+	fuzzy = g_new0(XbSiloFuzzyTokens, 1);
+	fuzzy->ref = 2;
+	fuzzy->search = g_strdup(search);
+	fuzzy->max_dist = max_dist;
+	fuzzy->tokens = g_array_new(FALSE, FALSE, sizeof(const gchar *));
+	search_tokens = g_str_tokenize_and_fold(search, NULL, &search_ascii_tokens);
+	for (guint k = 0; k < 2; k++) {
+		gchar **strv = (k == 0) ? search_tokens : search_ascii_tokens;
+		for (guint i = 0; strv[i] != NULL; i++) {
+			if (!xb_string_token_valid(strv[i]))
+				continue;
+			xb_silo_add_fuzzy_tokens(self, tokens, strv[i], max_dist, fuzzy->tokens);
+		}
+	}
+
+	/* remove duplicates */
+	g_array_sort(fuzzy->tokens, xb_silo_fuzzy_tokens_sort_cb);
+	for (guint i = 0; i < fuzzy->tokens->len; i++) {
+		const gchar *token = g_array_index(fuzzy->tokens, const gchar *, i);
+		if (j > 0 && g_array_index(fuzzy->tokens, const gchar *, j - 1) == token)
+			continue;
+		g_array_index(fuzzy->tokens, const gchar *, j++) = token;
+	}
+	g_array_set_size(fuzzy->tokens, j);
+
+	/* the queries using the old ones keep a reference */
+	if (g_hash_table_size(priv->fuzzy_tokens) >= XB_SILO_SEARCH_CACHE_MAX)
+		g_hash_table_remove_all(priv->fuzzy_tokens);
+	g_hash_table_insert(priv->fuzzy_tokens, g_steal_pointer(&key), fuzzy);
+	return fuzzy;
+}
+
+/* private */
+void
+xb_silo_search_tokens_unref(XbSiloSearchTokens *search_tokens)
+{
+	if (!g_atomic_int_dec_and_test(&search_tokens->ref))
+		return;
+	g_free(search_tokens->search);
+	g_strfreev(search_tokens->tokens);
+	g_free(search_tokens);
+}
+
+/* private: the tokens of a search string that was not tokenized when parsing
+ * the query, e.g. a bound value, with the most recent ones kept until the
+ * silo is reloaded */
+XbSiloSearchTokens *
+xb_silo_get_search_tokens(XbSilo *self, const gchar *search)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	XbSiloSearchTokens *search_tokens;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->stats_mutex);
+	g_autoptr(GPtrArray) tokens = g_ptr_array_new();
+	g_auto(GStrv) strv_tokens = NULL;
+	g_auto(GStrv) strv_ascii_tokens = NULL;
+
+	if (priv->search_tokens == NULL) {
+		priv->search_tokens =
+		    g_hash_table_new_full(g_str_hash,
+					  g_str_equal,
+					  NULL,
+					  (GDestroyNotify)xb_silo_search_tokens_unref);
+	}
+	search_tokens = g_hash_table_lookup(priv->search_tokens, search);
+	if (search_tokens != NULL) {
+		g_atomic_int_inc(&search_tokens->ref);
+		return search_tokens;
+	}
+
+	strv_tokens = g_str_tokenize_and_fold(search, NULL, &strv_ascii_tokens);
+	for (guint k = 0; k < 2; k++) {
+		gchar **strv = (k == 0) ? strv_tokens : strv_ascii_tokens;
+		for (guint i = 0; strv[i] != NULL; i++) {
+			if (!xb_string_token_valid(strv[i]))
+				continue;
+			g_ptr_array_add(tokens, g_strdup(strv[i]));
+		}
+	}
+	g_ptr_array_add(tokens, NULL);
+	search_tokens = g_new0(XbSiloSearchTokens, 1);
+	search_tokens->ref = 2;
+	search_tokens->search = g_strdup(search);
+	search_tokens->tokens = (gchar **)g_ptr_array_free(g_steal_pointer(&tokens), FALSE);
+
+	/* the queries using the old ones keep a reference */
+	if (g_hash_table_size(priv->search_tokens) >= XB_SILO_SEARCH_CACHE_MAX)
+		g_hash_table_remove_all(priv->search_tokens);
+	g_hash_table_insert(priv->search_tokens, search_tokens->search, search_tokens);
+	return search_tokens;
+}
+
+/* private: releases what the query kept from the silo caches */
+void
+xb_silo_query_data_clear(XbSiloQueryData *query_data)
+{
+	g_clear_pointer(&query_data->fuzzy_tokens, xb_silo_fuzzy_tokens_unref);
+	g_clear_pointer(&query_data->search_tokens, xb_silo_search_tokens_unref);
+}
+
+/* private: the number of tokenized nodes, and of the tokens in all of them */
+void
+xb_silo_get_token_totals(XbSilo *self, guint32 *nodes, guint32 *tokens)
+{
+	if (nodes != NULL)
+		*nodes = xb_silo_get_tokentab_value(self, XB_SILO_TOKENTAB_NODES);
+	if (tokens != NULL)
+		*tokens = xb_silo_get_tokentab_value(self, XB_SILO_TOKENTAB_TOKENS);
+}
+
+static guint32
+xb_silo_get_foldtab_value(XbSilo *self, guint idx)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	guint32 val;
+
+	if (idx >= (priv->datasz - priv->foldtab) / sizeof(guint32))
+		return XB_SILO_UNSET;
+
+	/* the foldtab follows the tokentab, so is not aligned */
+	memcpy(&val, priv->data + priv->foldtab + idx * sizeof(guint32), sizeof(val));
+	return val;
+}
+
+/* private: the strtab offset of the lower case copy of the string at @offset,
+ * or %XB_SILO_UNSET if the silo was built without
+ * %XB_BUILDER_COMPILE_FLAG_FOLD_CASE */
+guint32
+xb_silo_get_folded_idx(XbSilo *self, guint32 offset)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+	guint l = 0;
+	guint r;
+	guint pairs;
+
+	if (priv->foldtab == priv->datasz || offset == XB_SILO_UNSET)
+		return XB_SILO_UNSET;
+	pairs = xb_silo_get_foldtab_value(self, XB_SILO_FOLDTAB_PAIRS);
+	r = pairs;
+	while (l < r) {
+		guint m = l + (r - l) / 2;
+		if (xb_silo_get_foldtab_value(self, 1 + m * 2) < offset)
+			l = m + 1;
+		else
+			r = m;
+	}
+	if (l == pairs || xb_silo_get_foldtab_value(self, 1 + l * 2) != offset)
+		return offset;
+	return xb_silo_get_foldtab_value(self, 2 + l * 2);
+}
+
 /* private */
 guint32
 xb_silo_strtab_index_lookup(XbSilo *self, const gchar *str)
 {
 	XbSiloPrivate *priv = GET_PRIVATE(self);
 	gpointer val = NULL;
+	g_autoptr(GMutexLocker) locker = g_mutex_locker_new(&priv->strindex_mutex);
+
+	xb_silo_strtab_index_ensure(self);
 	if (!g_hash_table_lookup_extended(priv->strindex, str, NULL, &val))
 		return XB_SILO_UNSET;
 	return GPOINTER_TO_INT(val);
@@ -283,6 +758,21 @@ xb_silo_get_child_node(XbSilo *self, XbSiloNode *n)
 	return c;
 }
 
+/* private */
+guint32
+xb_silo_get_node_subtree_end(XbSilo *self, XbSiloNode *n)
+{
+	XbSiloPrivate *priv = GET_PRIVATE(self);
+
+	/* the nodetab is written depth-first, so all the descendants are
+	 * before the next sibling of the node or of the nearest ancestor */
+	for (XbSiloNode *tmp = n; tmp != NULL; tmp = xb_silo_get_parent_node(self, tmp)) {
+		if (tmp->next != 0x0)
+			return tmp->next;
+	}
+	return priv->strtab;
+}
+
 /**
  * xb_silo_get_root:
  * @self: a #XbSilo
@@ -339,11 +829,23 @@ xb_silo_to_string(XbSilo *self, GError **error)
 		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "strtab invalid");
 		return NULL;
 	}
+	if (hdr->tokentab < hdr->strtab || hdr->tokentab > priv->datasz) {
+		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "tokentab invalid");
+		return NULL;
+	}
+	if (hdr->foldtab < hdr->tokentab || hdr->foldtab > priv->datasz) {
+		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "foldtab invalid");
+		return NULL;
+	}
 
 	g_string_append_printf(str, "magic:        %08x\n", (guint)hdr->magic);
 	g_string_append_printf(str, "guid:         %s\n", priv->guid);
 	g_string_append_printf(str, "strtab:       @%" G_GUINT32_FORMAT "\n", hdr->strtab);
 	g_string_append_printf(str, "strtab_ntags: %" G_GUINT16_FORMAT "\n", hdr->strtab_ntags);
+	g_string_append_printf(str, "flags:        %" G_GUINT16_FORMAT "\n", hdr->flags);
+	g_string_append_printf(str, "strtab_tokens: @%" G_GUINT32_FORMAT "\n", hdr->strtab_tokens);
+	g_string_append_printf(str, "tokentab:     @%" G_GUINT32_FORMAT "\n", hdr->tokentab);
+	g_string_append_printf(str, "foldtab:      @%" G_GUINT32_FORMAT "\n", hdr->foldtab);
 	while (off < priv->strtab) {
 		XbSiloNode *n = xb_silo_get_node(self, off);
 		if (xb_silo_node_has_flag(n, XB_SILO_NODE_FLAG_IS_ELEMENT)) {
@@ -405,7 +907,7 @@ xb_silo_to_string(XbSilo *self, GError **error)
 
 	/* add strtab */
 	g_string_append_printf(str, "STRTAB @%" G_GUINT32_FORMAT "\n", hdr->strtab);
-	for (off = 0; off < priv->datasz - hdr->strtab;) {
+	for (off = 0; off < hdr->tokentab - hdr->strtab;) {
 		const gchar *tmp = xb_silo_from_strtab(self, off);
 		if (tmp == NULL)
 			break;
@@ -705,6 +1207,22 @@ xb_silo_load_from_bytes(XbSilo *self, GBytes *blob, XbSiloLoadFlags flags, GErro
 	g_hash_table_remove_all(priv->strtab_tags);
 	g_clear_pointer(&priv->guid, g_free);
 
+	/* the string offsets are only valid for the old blob */
+	g_mutex_lock(&priv->strindex_mutex);
+	g_hash_table_remove_all(priv->strindex);
+	priv->strindex_complete = FALSE;
+	g_mutex_unlock(&priv->strindex_mutex);
+	g_mutex_lock(&priv->stats_mutex);
+	g_clear_pointer(&priv->stats_elements, g_hash_table_unref);
+	g_clear_pointer(&priv->stats_values, g_hash_table_unref);
+	g_clear_pointer(&priv->tokens, g_array_unref);
+	g_clear_pointer(&priv->fuzzy_tokens, g_hash_table_unref);
+	g_clear_pointer(&priv->search_tokens, g_hash_table_unref);
+	g_mutex_unlock(&priv->stats_mutex);
+	g_rw_lock_writer_lock(&priv->query_cache_mutex);
+	g_hash_table_remove_all(priv->query_cache);
+	g_rw_lock_writer_unlock(&priv->query_cache_mutex);
+
 	/* refcount internally */
 	if (priv->blob != NULL)
 		g_bytes_unref(priv->blob);
@@ -744,6 +1262,7 @@ xb_silo_load_from_bytes(XbSilo *self, GBytes *blob, XbSiloLoadFlags flags, GErro
 	/* get GUID */
 	memcpy(&guid_tmp, &hdr->guid, sizeof(guid_tmp));
 	priv->guid = xb_guid_to_string(&guid_tmp);
+	priv->flags = hdr->flags;
 
 	/* check strtab */
 	priv->strtab = hdr->strtab;
@@ -751,6 +1270,30 @@ xb_silo_load_from_bytes(XbSilo *self, GBytes *blob, XbSiloLoadFlags flags, GErro
 		g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "strtab incorrect");
 		return FALSE;
 	}
+	priv->tokentab = hdr->tokentab;
+	if (priv->tokentab < priv->strtab || priv->tokentab > priv->datasz) {
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_INVALID_DATA,
+				    "tokentab incorrect");
+		return FALSE;
+	}
+	priv->foldtab = hdr->foldtab;
+	if (priv->foldtab < priv->tokentab || priv->foldtab > priv->datasz) {
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_INVALID_DATA,
+				    "foldtab incorrect");
+		return FALSE;
+	}
+	priv->strtab_tokens = hdr->strtab_tokens;
+	if (priv->strtab_tokens > priv->tokentab - priv->strtab) {
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_INVALID_DATA,
+				    "strtab_tokens incorrect");
+		return FALSE;
+	}
 
 	/* load strtab_tags */
 	for (guint16 i = 0; i < hdr->strtab_ntags; i++) {
@@ -1125,6 +1668,13 @@ xb_silo_new_from_xml(const gchar *xml, GError **error)
 /* private */
 XbNode *
 xb_silo_create_node(XbSilo *self, XbSiloNode *sn, gboolean force_node_cache)
+{
+	return xb_silo_create_node_full(self, sn, force_node_cache, NULL);
+}
+
+/* private: @cached is set if the node was already in the cache */
+XbNode *
+xb_silo_create_node_full(XbSilo *self, XbSiloNode *sn, gboolean force_node_cache, gboolean *cached)
 {
 	XbNode *n;
 	XbSiloPrivate *priv = GET_PRIVATE(self);
@@ -1146,8 +1696,11 @@ xb_silo_create_node(XbSilo *self, XbSiloNode *sn, gboolean force_node_cache)
 
 	/* does already exist */
 	n = g_hash_table_lookup(priv->nodes, sn);
-	if (n != NULL)
+	if (n != NULL) {
+		if (cached != NULL)
+			*cached = TRUE;
 		return g_object_ref(n);
+	}
 
 	/* create and add */
 	n = xb_node_new(self, sn);
@@ -1247,6 +1800,25 @@ xb_silo_machine_fixup_attr_search_token_cb(XbMachine *self,
 	return TRUE;
 }
 
+/* convert "text() lower-case()" -> "text() lower-case-indexed()" so that the
+ * lower case copy in the strtab can be used rather than allocating a string */
+static gboolean
+xb_silo_machine_fixup_lower_case_cb(XbMachine *self,
+				    XbStack *opcodes,
+				    gpointer user_data,
+				    GError **error)
+{
+	for (guint i = 0; i < xb_stack_get_size(opcodes); i++) {
+		XbOpcode *op = xb_stack_peek(opcodes, i);
+		if (xb_opcode_get_kind(op) != XB_OPCODE_KIND_FUNCTION ||
+		    g_strcmp0(xb_opcode_get_str(op), "lower-case") != 0)
+			continue;
+		xb_opcode_clear(op);
+		xb_machine_opcode_func_init(self, op, "lower-case-indexed");
+	}
+	return TRUE;
+}
+
 static gboolean
 xb_silo_machine_func_attr_cb(XbMachine *self,
 			     XbStack *stack,
@@ -1302,12 +1874,11 @@ xb_silo_machine_func_stem_cb(XbMachine *self,
 			     gpointer exec_data,
 			     GError **error)
 {
-	XbSilo *silo = XB_SILO(user_data);
 	XbOpcode *head;
 	const gchar *str;
 	g_auto(XbOpcode) op = XB_OPCODE_INIT();
 
-	head = xb_stack_peek_head(stack);
+	head = xb_stack_peek_tail(stack);
 	if (head == NULL || !xb_opcode_cmp_str(head)) {
 		g_set_error(error,
 			    G_IO_ERROR,
@@ -1323,7 +1894,63 @@ xb_silo_machine_func_stem_cb(XbMachine *self,
 
 	/* TEXT */
 	str = xb_opcode_get_str(&op);
-	return xb_machine_stack_push_text_steal(self, stack, xb_silo_stem(silo, str), error);
+	if (!xb_machine_stack_push_text_steal(self, stack, xb_string_stem(str), error))
+		return FALSE;
+
+	/* a literal is stemmed once when optimizing, so tokenize it too so that
+	 * search() can compare it with the stemmed tokens in the silo */
+	if (exec_data == NULL)
+		xb_machine_opcode_tokenize(self, xb_stack_peek_tail(stack));
+	return TRUE;
+}
+
+static gboolean
+xb_silo_machine_func_lower_indexed_cb(XbMachine *self,
+				      XbStack *stack,
+				      gboolean *result,
+				      gpointer user_data,
+				      gpointer exec_data,
+				      GError **error)
+{
+	XbOpcode *head;
+	XbSilo *silo = XB_SILO(user_data);
+	const gchar *str;
+	g_auto(XbOpcode) op = XB_OPCODE_INIT();
+
+	head = xb_stack_peek_tail(stack);
+	if (head == NULL || !xb_opcode_cmp_str(head)) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_NOT_SUPPORTED,
+			    "%s type not supported",
+			    (head != NULL) ? xb_opcode_kind_to_string(xb_opcode_get_kind(head))
+					   : "(null)");
+		return FALSE;
+	}
+	if (!xb_machine_stack_pop(self, stack, &op, error))
+		return FALSE;
+
+	/* use the lower case copy from the strtab */
+	if (xb_opcode_get_kind(&op) == XB_OPCODE_KIND_INDEXED_TEXT) {
+		guint32 val = xb_silo_get_folded_idx(silo, xb_opcode_get_val(&op));
+		if (val != XB_SILO_UNSET) {
+			XbOpcode *op2;
+			if (!xb_machine_stack_push(self, stack, &op2, error))
+				return FALSE;
+			xb_opcode_init(op2,
+				       XB_OPCODE_KIND_INDEXED_TEXT,
+				       xb_silo_from_strtab(silo, val),
+				       val,
+				       NULL);
+			return TRUE;
+		}
+	}
+
+	/* TEXT */
+	str = xb_opcode_get_str(&op);
+	if (str == NULL)
+		return xb_machine_stack_push_text_static(self, stack, NULL, error);
+	return xb_machine_stack_push_text_steal(self, stack, g_utf8_strdown(str, -1), error);
 }
 
 static gboolean
@@ -1464,6 +2091,139 @@ xb_silo_machine_func_position_cb(XbMachine *self,
 	return xb_machine_stack_push_integer(self, stack, query_data->position, error);
 }
 
+static gboolean
+xb_silo_machine_func_count_cb(XbMachine *self,
+			      XbStack *stack,
+			      gboolean *result,
+			      gpointer user_data,
+			      gpointer exec_data,
+			      GError **error)
+{
+	XbSilo *silo = XB_SILO(user_data);
+	XbSiloQueryData *query_data = (XbSiloQueryData *)exec_data;
+	g_auto(XbOpcode) op = XB_OPCODE_INIT();
+	gboolean wildcard = FALSE;
+	guint32 element_idx;
+	guint32 cnt = 0;
+
+	/* optimize pass */
+	if (query_data == NULL) {
+		g_set_error_literal(error,
+				    G_IO_ERROR,
+				    G_IO_ERROR_FAILED_HANDLED,
+				    "cannot optimize: no silo to query");
+		return FALSE;
+	}
+
+	if (!xb_machine_stack_pop(self, stack, &op, error))
+		return FALSE;
+	if (!xb_opcode_cmp_str(&op)) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_NOT_SUPPORTED,
+			    "%s type not supported",
+			    xb_opcode_kind_to_string(xb_opcode_get_kind(&op)));
+		return FALSE;
+	}
+
+	/* indexed string */
+	if (g_strcmp0(xb_opcode_get_str(&op), "*") == 0) {
+		element_idx = XB_SILO_UNSET;
+		wildcard = TRUE;
+	} else if (xb_opcode_cmp_indexed(&op)) {
+		element_idx = xb_opcode_get_val(&op);
+	} else {
+		element_idx = xb_silo_get_strtab_idx(silo, xb_opcode_get_str(&op));
+	}
+
+	/* count the children, without creating any nodes */
+	if (wildcard || element_idx != XB_SILO_UNSET) {
+		for (XbSiloNode *c = xb_silo_get_child_node(silo, query_data->sn); c != NULL;
+		     c = xb_silo_get_next_node(silo, c)) {
+			if (wildcard || c->element_name == element_idx)
+				cnt++;
+		}
+	}
+	return xb_machine_stack_push_integer(self, stack, cnt, error);
+}
+
+/* the range of tokens starting with @token, cached in @query_data */
+static XbSiloQueryTokenRange *
+xb_silo_query_data_get_token_range(XbSilo *self,
+				   XbSiloQueryData *query_data,
+				   const gchar *token,
+				   XbSiloQueryTokenRange *range_tmp)
+{
+	XbSiloQueryTokenRange *range = range_tmp;
+
+	if (query_data != NULL) {
+		for (guint i = 0; i < query_data->token_ranges_len; i++) {
+			if (query_data->token_ranges[i].token == token)
+				return &query_data->token_ranges[i];
+		}
+		if (query_data->token_ranges_len < XB_SILO_QUERY_TOKEN_RANGES_MAX)
+			range = &query_data->token_ranges[query_data->token_ranges_len++];
+	}
+	range->token = token;
+	if (!xb_silo_get_token_range(self, token, &range->lo, &range->hi)) {
+		range->lo = NULL;
+		range->hi = NULL;
+	}
+	return range;
+}
+
+/* like xb_string_searchv(), but tokens from the silo are matched against the
+ * range of tokens starting with each search token */
+static gboolean
+xb_silo_search_tokens(XbSilo *self,
+		      XbSiloQueryData *query_data,
+		      const gchar **text,
+		      const gchar **search)
+{
+	if (text == NULL || text[0] == NULL || text[0][0] == '\0')
+		return FALSE;
+	if (search == NULL || search[0] == NULL || search[0][0] == '\0')
+		return FALSE;
+	for (guint j = 0; text[j] != NULL; j++) {
+		if (!xb_silo_is_token(self, text[j]))
+			return xb_string_searchv(text, search);
+	}
+	for (guint i = 0; search[i] != NULL; i++) {
+		XbSiloQueryTokenRange range_tmp;
+		XbSiloQueryTokenRange *range =
+		    xb_silo_query_data_get_token_range(self, query_data, search[i], &range_tmp);
+		if (range->lo == NULL)
+			continue;
+		for (guint j = 0; text[j] != NULL; j++) {
+			if (text[j] >= range->lo && text[j] < range->hi)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* the tokens of @search, cached in @query_data */
+static XbSiloSearchTokens *
+xb_silo_query_data_get_search_tokens(XbSilo *self,
+				     XbSiloQueryData *query_data,
+				     const gchar *search)
+{
+	XbSiloSearchTokens *search_tokens;
+
+	if (query_data != NULL && query_data->search_tokens != NULL &&
+	    strcmp(query_data->search_tokens->search, search) == 0) {
+		g_atomic_int_inc(&query_data->search_tokens->ref);
+		return query_data->search_tokens;
+	}
+	search_tokens = xb_silo_get_search_tokens(self, search);
+	if (query_data != NULL) {
+		g_clear_pointer(&query_data->search_tokens, xb_silo_search_tokens_unref);
+		g_atomic_int_inc(&search_tokens->ref);
+		query_data->search_tokens = search_tokens;
+	}
+	return search_tokens;
+}
+
 static gboolean
 xb_silo_machine_func_search_cb(XbMachine *self,
 			       XbStack *stack,
@@ -1504,17 +2264,37 @@ xb_silo_machine_func_search_cb(XbMachine *self,
 	/* TOKN:TOKN */
 	if (xb_opcode_has_flag(&op1, XB_OPCODE_FLAG_TOKENIZED) &&
 	    xb_opcode_has_flag(&op2, XB_OPCODE_FLAG_TOKENIZED)) {
-		return xb_stack_push_bool(
-		    stack,
-		    xb_string_searchv(xb_opcode_get_tokens(&op2), xb_opcode_get_tokens(&op1)),
-		    error);
+		return xb_stack_push_bool(stack,
+					  xb_silo_search_tokens(silo,
+								(XbSiloQueryData *)exec_data,
+								xb_opcode_get_tokens(&op2),
+								xb_opcode_get_tokens(&op1)),
+					  error);
 	}
 
-	/* this is going to be slow, but correct */
+	/* TOKN:TEXT, e.g. a bound value, so only tokenize the search once -- but
+	 * only when the builder tokenized the text because it is not ASCII, as the
+	 * tokens do not match short or multi-word searches like the text does */
 	text = xb_opcode_get_str(&op2);
 	search = xb_opcode_get_str(&op1);
 	if (text == NULL || search == NULL || text[0] == '\0' || search[0] == '\0')
 		return xb_stack_push_bool(stack, FALSE, error);
+	if (xb_opcode_has_flag(&op2, XB_OPCODE_FLAG_TOKENIZED) &&
+	    priv->flags & XB_SILO_HEADER_FLAG_TOKENIZE_NON_ASCII &&
+	    (!g_str_is_ascii(text) || !g_str_is_ascii(search))) {
+		XbSiloQueryData *query_data = (XbSiloQueryData *)exec_data;
+		g_autoptr(XbSiloSearchTokens) search_tokens =
+		    xb_silo_query_data_get_search_tokens(silo, query_data, search);
+		return xb_stack_push_bool(
+		    stack,
+		    xb_silo_search_tokens(silo,
+					  query_data,
+					  xb_opcode_get_tokens(&op2),
+					  (const gchar **)search_tokens->tokens),
+		    error);
+	}
+
+	/* this is going to be slow, but correct */
 	if (!g_str_is_ascii(text) || !g_str_is_ascii(search)) {
 		if (priv->profile_flags & XB_SILO_PROFILE_FLAG_DEBUG) {
 			g_debug("tokenization for [%s:%s] may be slow!", text, search);
@@ -1526,6 +2306,139 @@ xb_silo_machine_func_search_cb(XbMachine *self,
 	return xb_stack_push_bool(stack, xb_string_search(text, search), error);
 }
 
+/* the tokens close to @search, cached in @query_data */
+static XbSiloFuzzyTokens *
+xb_silo_query_data_get_fuzzy_tokens(XbSilo *self,
+				    XbSiloQueryData *query_data,
+				    const gchar *search,
+				    guint max_dist)
+{
+	XbSiloFuzzyTokens *fuzzy;
+
+	if (query_data != NULL && query_data->fuzzy_tokens != NULL &&
+	    query_data->fuzzy_tokens->max_dist == max_dist &&
+	    strcmp(query_data->fuzzy_tokens->search, search) == 0) {
+		g_atomic_int_inc(&query_data->fuzzy_tokens->ref);
+		return query_data->fuzzy_tokens;
+	}
+	fuzzy = xb_silo_get_fuzzy_tokens(self, search, max_dist);
+	if (query_data != NULL) {
+		g_clear_pointer(&query_data->fuzzy_tokens, xb_silo_fuzzy_tokens_unref);
+		g_atomic_int_inc(&fuzzy->ref);
+		query_data->fuzzy_tokens = fuzzy;
+	}
+	return fuzzy;
+}
+
+static gboolean
+xb_silo_fuzzy_tokens_contains(XbSiloFuzzyTokens *fuzzy, const gchar *token)
+{
+	const gchar **tokens = (const gchar **)fuzzy->tokens->data;
+	guint l = 0;
+	guint r = fuzzy->tokens->len;
+
+	while (l < r) {
+		guint m = l + (r - l) / 2;
+		if (tokens[m] == token)
+			return TRUE;
+		if (tokens[m] < token)
+			l = m + 1;
+		else
+			r = m;
+	}
+	return FALSE;
+}
+
+/* like search(), but matches whole tokens within @max_dist edits */
+static gboolean
+xb_silo_machine_func_search_fuzzy_cb(XbMachine *self,
+				     XbStack *stack,
+				     gboolean *result,
+				     gpointer user_data,
+				     gpointer exec_data,
+				     GError **error)
+{
+	XbSilo *silo = XB_SILO(user_data);
+	const gchar **tokens;
+	const gchar *text;
+	const gchar *search;
+	guint max_dist;
+	gboolean tokenized;
+	g_auto(GStrv) text_tokens = NULL;
+	g_auto(GStrv) text_ascii_tokens = NULL;
+	g_auto(GStrv) search_tokens = NULL;
+	g_auto(GStrv) search_ascii_tokens = NULL;
+	g_auto(XbOpcode) op1 = XB_OPCODE_INIT();
+	g_auto(XbOpcode) op2 = XB_OPCODE_INIT();
+	g_auto(XbOpcode) op3 = XB_OPCODE_INIT();
+
+	if (!xb_machine_stack_pop(self, stack, &op1, error))
+		return FALSE;
+	if (!xb_machine_stack_pop_two(self, stack, &op2, &op3, error))
+		return FALSE;
+	if (!xb_opcode_cmp_val(&op1) || !xb_opcode_cmp_str(&op2) || !xb_opcode_cmp_str(&op3)) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_NOT_SUPPORTED,
+			    "%s:%s:%s types not supported",
+			    xb_opcode_kind_to_string(xb_opcode_get_kind(&op3)),
+			    xb_opcode_kind_to_string(xb_opcode_get_kind(&op2)),
+			    xb_opcode_kind_to_string(xb_opcode_get_kind(&op1)));
+		return FALSE;
+	}
+	max_dist = xb_opcode_get_val(&op1);
+	if (max_dist > XB_SILO_FUZZY_DISTANCE_MAX) {
+		g_set_error(error,
+			    G_IO_ERROR,
+			    G_IO_ERROR_NOT_SUPPORTED,
+			    "edit distance %u not supported, maximum is %u",
+			    max_dist,
+			    (guint)XB_SILO_FUZZY_DISTANCE_MAX);
+		return FALSE;
+	}
+	text = xb_opcode_get_str(&op3);
+	search = xb_opcode_get_str(&op2);
+	if (text == NULL || search == NULL || text[0] == '\0' || search[0] == '\0')
+		return xb_stack_push_bool(stack, FALSE, error);
+
+	/* tokens from the silo can be looked up in the tokens found once */
+	tokens = xb_opcode_get_tokens(&op3);
+	tokenized = xb_opcode_has_flag(&op3, XB_OPCODE_FLAG_TOKENIZED);
+	for (guint i = 0; tokenized && tokens[i] != NULL; i++)
+		tokenized = xb_silo_is_token(silo, tokens[i]);
+	if (tokenized) {
+		g_autoptr(XbSiloFuzzyTokens) fuzzy =
+		    xb_silo_query_data_get_fuzzy_tokens(silo,
+							(XbSiloQueryData *)exec_data,
+							search,
+							max_dist);
+		for (guint i = 0; tokens[i] != NULL; i++) {
+			if (xb_silo_fuzzy_tokens_contains(fuzzy, tokens[i]))
+				return xb_stack_push_bool(stack, TRUE, error);
+		}
+		return xb_stack_push_bool(stack, FALSE, error);
+	}
+
+	/* this is going to be slow, but correct */
+	text_tokens = g_str_tokenize_and_fold(text, NULL, &text_ascii_tokens);
+	search_tokens = g_str_tokenize_and_fold(search, NULL, &search_ascii_tokens);
+	for (guint k = 0; k < 4; k++) {
+		gchar **strv1 = (k & 1) == 0 ? text_tokens : text_ascii_tokens;
+		gchar **strv2 = (k & 2) == 0 ? search_tokens : search_ascii_tokens;
+		for (guint i = 0; strv1[i] != NULL; i++) {
+			if (!xb_string_token_valid(strv1[i]))
+				continue;
+			for (guint j = 0; strv2[j] != NULL; j++) {
+				if (!xb_string_token_valid(strv2[j]))
+					continue;
+				if (xb_string_levenshtein_within(strv1[i], strv2[j], max_dist))
+					return xb_stack_push_bool(stack, TRUE, error);
+			}
+		}
+	}
+	return xb_stack_push_bool(stack, FALSE, error);
+}
+
 static gboolean
 xb_silo_machine_fixup_attr_text_cb(XbMachine *self,
 				   XbStack *opcodes,
@@ -1619,6 +2532,15 @@ static void
 xb_silo_init(XbSilo *self)
 {
 	XbSiloPrivate *priv = GET_PRIVATE(self);
+	const gchar *lower_case_sigs[] = {"FUNC:text,FUNC:lower-case,TEXT,FUNC:eq",
+					  "FUNC:text,FUNC:lower-case,BIND,FUNC:eq",
+					  "TEXT,FUNC:text,FUNC:lower-case,FUNC:eq",
+					  "BIND,FUNC:text,FUNC:lower-case,FUNC:eq",
+					  "TEXT,FUNC:attr,FUNC:lower-case,TEXT,FUNC:eq",
+					  "TEXT,FUNC:attr,FUNC:lower-case,BIND,FUNC:eq",
+					  "TEXT,TEXT,FUNC:attr,FUNC:lower-case,FUNC:eq",
+					  "BIND,TEXT,FUNC:attr,FUNC:lower-case,FUNC:eq",
+					  NULL};
 
 	priv->file_monitors = g_hash_table_new_full(g_file_hash,
 						    (GEqualFunc)g_file_equal,
@@ -1628,6 +2550,8 @@ xb_silo_init(XbSilo *self)
 
 	priv->strtab_tags = g_hash_table_new(g_str_hash, g_str_equal);
 	priv->strindex = g_hash_table_new(g_str_hash, g_str_equal);
+	g_mutex_init(&priv->strindex_mutex);
+	g_mutex_init(&priv->stats_mutex);
 	priv->profile_str = g_string_new(NULL);
 	priv->query_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
 	g_rw_lock_init(&priv->query_cache_mutex);
@@ -1637,10 +2561,6 @@ xb_silo_init(XbSilo *self)
 
 	priv->context = g_main_context_ref_thread_default();
 
-#ifdef HAVE_LIBSTEMMER
-	g_mutex_init(&priv->stemmer_mutex);
-#endif
-
 	priv->machine = xb_machine_new();
 	xb_machine_add_method(priv->machine, "attr", 1, xb_silo_machine_func_attr_cb, self, NULL);
 	xb_machine_add_method(priv->machine, "stem", 1, xb_silo_machine_func_stem_cb, self, NULL);
@@ -1648,6 +2568,7 @@ xb_silo_init(XbSilo *self)
 	xb_machine_add_method(priv->machine, "tail", 0, xb_silo_machine_func_tail_cb, self, NULL);
 	xb_machine_add_method(priv->machine, "first", 0, xb_silo_machine_func_first_cb, self, NULL);
 	xb_machine_add_method(priv->machine, "last", 0, xb_silo_machine_func_last_cb, self, NULL);
+	xb_machine_add_method(priv->machine, "count", 1, xb_silo_machine_func_count_cb, self, NULL);
 	xb_machine_add_method(priv->machine,
 			      "position",
 			      0,
@@ -1660,6 +2581,18 @@ xb_silo_init(XbSilo *self)
 			      xb_silo_machine_func_search_cb,
 			      self,
 			      NULL);
+	xb_machine_add_method(priv->machine,
+			      "search-fuzzy",
+			      3,
+			      xb_silo_machine_func_search_fuzzy_cb,
+			      self,
+			      NULL);
+	xb_machine_add_method(priv->machine,
+			      "lower-case-indexed",
+			      1,
+			      xb_silo_machine_func_lower_indexed_cb,
+			      self,
+			      NULL);
 	xb_machine_add_operator(priv->machine, "~=", "search");
 	xb_machine_add_opcode_fixup(priv->machine,
 				    "INTE",
@@ -1676,6 +2609,13 @@ xb_silo_init(XbSilo *self)
 				    xb_silo_machine_fixup_attr_search_token_cb,
 				    self,
 				    NULL);
+	for (guint i = 0; lower_case_sigs[i] != NULL; i++) {
+		xb_machine_add_opcode_fixup(priv->machine,
+					    lower_case_sigs[i],
+					    xb_silo_machine_fixup_lower_case_cb,
+					    self,
+					    NULL);
+	}
 	xb_machine_add_text_handler(priv->machine, xb_silo_machine_fixup_attr_text_cb, self, NULL);
 }
 
@@ -1688,12 +2628,6 @@ xb_silo_finalize(GObject *obj)
 	g_clear_pointer(&priv->nodes, g_hash_table_unref);
 	g_mutex_clear(&priv->nodes_mutex);
 
-#ifdef HAVE_LIBSTEMMER
-	if (priv->stemmer_ctx != NULL)
-		sb_stemmer_delete(priv->stemmer_ctx);
-	g_mutex_clear(&priv->stemmer_mutex);
-#endif
-
 	g_clear_pointer(&priv->context, g_main_context_unref);
 
 	g_free(priv->guid);
@@ -1702,6 +2636,18 @@ xb_silo_finalize(GObject *obj)
 	g_rw_lock_clear(&priv->query_cache_mutex);
 	g_object_unref(priv->machine);
 	g_hash_table_unref(priv->strindex);
+	g_mutex_clear(&priv->strindex_mutex);
+	if (priv->stats_elements != NULL)
+		g_hash_table_unref(priv->stats_elements);
+	if (priv->stats_values != NULL)
+		g_hash_table_unref(priv->stats_values);
+	if (priv->tokens != NULL)
+		g_array_unref(priv->tokens);
+	if (priv->fuzzy_tokens != NULL)
+		g_hash_table_unref(priv->fuzzy_tokens);
+	if (priv->search_tokens != NULL)
+		g_hash_table_unref(priv->search_tokens);
+	g_mutex_clear(&priv->stats_mutex);
 	g_hash_table_unref(priv->file_monitors);
 	g_mutex_clear(&priv->file_monitors_mutex);
 	g_hash_table_unref(priv->strtab_tags);
@@ -1811,10 +2757,11 @@ xb_silo_lookup_query(XbSilo *self, const gchar *xpath)
 
 	g_rw_lock_reader_lock(&priv->query_cache_mutex);
 	result = g_hash_table_lookup(priv->query_cache, xpath);
+	if (result != NULL)
+		g_object_ref(result);
 	g_rw_lock_reader_unlock(&priv->query_cache_mutex);
 
 	if (result != NULL) {
-		g_object_ref(result);
 		g_debug("Found cached query ‘%s’ (%p) in silo %p", xpath, result, self);
 	} else {
 		g_autoptr(XbQuery) query = NULL;
@@ -20,8 +20,20 @@ gboolean
 xb_string_search(const gchar *text, const gchar *search);
 gboolean
 xb_string_searchv(const gchar **text, const gchar **search);
+guint
+xb_string_levenshtein_row(const gunichar *search,
+			  gsize search_len,
+			  const guint *prev,
+			  guint *row,
+			  gunichar c);
+gboolean
+xb_string_levenshtein_within(const gchar *text, const gchar *search, guint max_dist);
+gchar *
+xb_string_stem(const gchar *value);
 gboolean
 xb_string_token_valid(const gchar *text);
+gboolean
+xb_string_tokenize_ascii(const gchar *text, GPtrArray *tokens);
 gchar *
 xb_string_xml_escape(const gchar *str);
 gboolean
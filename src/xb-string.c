@@ -11,6 +11,10 @@
 #include <gio/gio.h>
 #include <string.h>
 
+#ifdef HAVE_LIBSTEMMER
+#include <libstemmer.h>
+#endif
+
 #include "xb-string-private.h"
 
 /**
@@ -114,23 +118,12 @@ xb_string_append_union(GString *xpath, const gchar *fmt, ...)
 gboolean
 xb_string_contains(const gchar *text, const gchar *search)
 {
-	guint search_sz;
-	guint text_sz;
-
 	/* can't possibly match */
 	if (text == NULL || search == NULL)
 		return FALSE;
 
-	/* sanity check */
-	text_sz = strlen(text);
-	search_sz = strlen(search);
-	if (search_sz > text_sz)
-		return FALSE;
-	for (guint i = 0; i < text_sz - search_sz + 1; i++) {
-		if (strncmp(text + i, search, search_sz) == 0)
-			return TRUE;
-	}
-	return FALSE;
+	/* the C library uses a linear-time search, vectorized where possible */
+	return strstr(text, search) != NULL;
 }
 
 /**
@@ -151,9 +144,9 @@ xb_string_contains(const gchar *text, const gchar *search)
 gboolean
 xb_string_search(const gchar *text, const gchar *search)
 {
-	guint search_sz;
-	guint text_sz;
-	gboolean is_sow = TRUE;
+	gsize search_sz;
+	gsize text_sz;
+	gchar first;
 
 	/* can't possibly match */
 	if (text == NULL || text[0] == '\0')
@@ -166,17 +159,19 @@ xb_string_search(const gchar *text, const gchar *search)
 	search_sz = strlen(search);
 	if (search_sz > text_sz)
 		return FALSE;
-	for (guint i = 0; i < text_sz - search_sz + 1; i++) {
-		if (!g_ascii_isalnum(text[i])) {
-			is_sow = TRUE;
+	first = g_ascii_tolower(search[0]);
+	for (gsize i = 0; i < text_sz - search_sz + 1; i++) {
+		if (!g_ascii_isalnum(text[i]))
 			continue;
-		}
-		if (!is_sow)
-			continue;
-		if (g_ascii_strncasecmp(text + i, search, search_sz) == 0)
+
+		/* only compare the rest if the first byte matches */
+		if (g_ascii_tolower(text[i]) == first &&
+		    g_ascii_strncasecmp(text + i + 1, search + 1, search_sz - 1) == 0)
 			return TRUE;
-		/* no longer the start of the word */
-		is_sow = FALSE;
+
+		/* no longer the start of the word, so skip to the end of it */
+		while (i + 1 < text_sz && g_ascii_isalnum(text[i + 1]))
+			i++;
 	}
 	return FALSE;
 }
@@ -212,6 +207,157 @@ xb_string_searchv(const gchar **text, const gchar **search)
 	return FALSE;
 }
 
+/* private: fills @row with the edit distances of each prefix of @search from
+ * the text that gave @prev followed by @c, where each row has @search_len + 1
+ * entries; returns the smallest of them, so a caller can stop once no text
+ * starting this way can be close enough */
+guint
+xb_string_levenshtein_row(const gunichar *search,
+			  gsize search_len,
+			  const guint *prev,
+			  guint *row,
+			  gunichar c)
+{
+	guint min;
+
+	row[0] = prev[0] + 1;
+	min = row[0];
+	for (gsize j = 1; j <= search_len; j++) {
+		guint val = prev[j - 1] + (search[j - 1] != c ? 1 : 0);
+		val = MIN(val, prev[j] + 1);
+		val = MIN(val, row[j - 1] + 1);
+		row[j] = val;
+		min = MIN(min, val);
+	}
+	return min;
+}
+
+/* private: if @text can be changed into @search with at most @max_dist
+ * single character insertions, deletions or substitutions */
+gboolean
+xb_string_levenshtein_within(const gchar *text, const gchar *search, guint max_dist)
+{
+	glong search_len = 0;
+	g_autofree gunichar *search_ucs4 = g_utf8_to_ucs4_fast(search, -1, &search_len);
+	g_autofree guint *prev = g_new(guint, search_len + 1);
+	g_autofree guint *row = g_new(guint, search_len + 1);
+
+	for (glong j = 0; j <= search_len; j++)
+		prev[j] = j;
+	for (const gchar *tmp = text; *tmp != '\0'; tmp = g_utf8_next_char(tmp)) {
+		guint *swap;
+		if (xb_string_levenshtein_row(search_ucs4,
+					      search_len,
+					      prev,
+					      row,
+					      g_utf8_get_char(tmp)) > max_dist)
+			return FALSE;
+		swap = prev;
+		prev = row;
+		row = swap;
+	}
+	return prev[search_len] <= max_dist;
+}
+
+#ifdef HAVE_LIBSTEMMER
+/* the stemmer keeps state between calls, so each thread has its own one,
+ * along with the last few results */
+#define XB_STRING_STEM_MEMO_MAX 1024
+
+typedef struct {
+	struct sb_stemmer *ctx;
+	GHashTable *memo; /* casefolded value to stem */
+} XbStringStemmer;
+
+static void
+xb_string_stemmer_free(XbStringStemmer *stemmer)
+{
+	sb_stemmer_delete(stemmer->ctx);
+	g_hash_table_unref(stemmer->memo);
+	g_free(stemmer);
+}
+
+static GPrivate xb_string_stemmer_private =
+    G_PRIVATE_INIT((GDestroyNotify)xb_string_stemmer_free);
+
+static XbStringStemmer *
+xb_string_stemmer_get(void)
+{
+	XbStringStemmer *stemmer = g_private_get(&xb_string_stemmer_private);
+	if (stemmer == NULL) {
+		stemmer = g_new0(XbStringStemmer, 1);
+		stemmer->ctx = sb_stemmer_new("en", NULL);
+		stemmer->memo = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		g_private_set(&xb_string_stemmer_private, stemmer);
+	}
+	return stemmer;
+}
+#endif
+
+/* private: returns the casefolded stem of @value, e.g. `gimping` -> `gimp`,
+ * or just the casefolded value if stemming is not supported; this can be
+ * called from any thread without taking a lock */
+gchar *
+xb_string_stem(const gchar *value)
+{
+#ifdef HAVE_LIBSTEMMER
+	XbStringStemmer *stemmer = xb_string_stemmer_get();
+	const gchar *tmp;
+	gsize len_dst;
+	gsize len_src;
+	g_autofree gchar *value_casefold = g_utf8_casefold(value, -1);
+	gchar *stem;
+
+	/* seen recently */
+	stem = g_hash_table_lookup(stemmer->memo, value_casefold);
+	if (stem != NULL)
+		return g_strdup(stem);
+
+	/* stem */
+	len_src = strlen(value_casefold);
+	tmp = (const gchar *)sb_stemmer_stem(stemmer->ctx,
+					     (guchar *)value_casefold,
+					     (gint)len_src);
+	len_dst = (gsize)sb_stemmer_length(stemmer->ctx);
+	stem = (len_src == len_dst) ? g_strdup(value_casefold) : g_strndup(tmp, len_dst);
+	if (g_hash_table_size(stemmer->memo) >= XB_STRING_STEM_MEMO_MAX)
+		g_hash_table_remove_all(stemmer->memo);
+	g_hash_table_insert(stemmer->memo, g_steal_pointer(&value_casefold), g_strdup(stem));
+	return stem;
+#else
+	return g_utf8_casefold(value, -1);
+#endif
+}
+
+/* private: adds the valid lower case tokens of @text to @tokens, splitting on
+ * anything that is not a letter or digit in the same way as
+ * g_str_tokenize_and_fold(), or returns %FALSE without changing @tokens if
+ * @text is not ASCII and has to be normalized */
+gboolean
+xb_string_tokenize_ascii(const gchar *text, GPtrArray *tokens)
+{
+	guint tokens_len = tokens->len;
+	gsize start = 0;
+
+	for (gsize i = 0;; i++) {
+		guchar c = text[i];
+		if (c >= 0x80) {
+			g_ptr_array_set_size(tokens, tokens_len);
+			return FALSE;
+		}
+		if (g_ascii_isalnum(c))
+			continue;
+
+		/* same as xb_string_token_valid() */
+		if (i - start >= 3)
+			g_ptr_array_add(tokens, g_ascii_strdown(text + start, i - start));
+		if (c == '\0')
+			break;
+		start = i + 1;
+	}
+	return TRUE;
+}
+
 /**
  * xb_string_token_valid: (skip)
  * @text: The potential token
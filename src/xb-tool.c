@@ -246,6 +246,7 @@ xb_tool_query(XbToolPrivate *priv, gchar **values, GError **error)
 	g_autoptr(GFile) file = NULL;
 	g_autoptr(GPtrArray) results = NULL;
 	g_autoptr(XbQuery) query = NULL;
+	g_autoptr(XbQueryProfile) profile = NULL;
 	g_autoptr(XbSilo) silo = xb_silo_new();
 	g_auto(XbQueryContext) context = XB_QUERY_CONTEXT_INIT();
 
@@ -280,7 +281,15 @@ xb_tool_query(XbToolPrivate *priv, gchar **values, GError **error)
 	query = xb_query_new_full(silo, values[1], XB_QUERY_FLAG_OPTIMIZE, error);
 	if (query == NULL)
 		return FALSE;
-	results = xb_silo_query_with_context(silo, query, &context, error);
+	if (priv->profile) {
+		results = xb_silo_query_with_profile(silo, query, &context, &profile, error);
+		if (profile != NULL) {
+			g_autofree gchar *tmp = xb_query_profile_to_string(profile);
+			g_print("%s", tmp);
+		}
+	} else {
+		results = xb_silo_query_with_context(silo, query, &context, error);
+	}
 	if (results == NULL)
 		return FALSE;
 	for (guint i = 0; i < results->len; i++) {
@@ -10,3 +10,10 @@
 
 gchar *
 xb_value_bindings_to_string(XbValueBindings *self);
+void
+xb_value_bindings_bind_indexed_str(XbValueBindings *self,
+				   guint idx,
+				   const gchar *str,
+				   guint32 val);
+const gchar *
+xb_value_bindings_get_str(XbValueBindings *self, guint idx);
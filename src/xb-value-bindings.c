@@ -24,12 +24,16 @@ typedef struct {
 		KIND_NONE,
 		KIND_TEXT,
 		KIND_INTEGER,
+		KIND_INDEXED_TEXT,
 	} kind;
 	union {
 		gchar *text;
 		guint32 integer;
 	};
-	GDestroyNotify destroy_func;
+	union {
+		GDestroyNotify destroy_func; /* for KIND_TEXT */
+		guint32 indexed;	     /* for KIND_INDEXED_TEXT */
+	};
 } BoundValue;
 
 typedef struct {
@@ -118,6 +122,8 @@ xb_value_bindings_to_string(XbValueBindings *self)
 			g_string_append_printf(str, "?%u → %u", i, value->integer);
 		else if (value->kind == KIND_TEXT)
 			g_string_append_printf(str, "?%u → %s", i, value->text);
+		else if (value->kind == KIND_INDEXED_TEXT)
+			g_string_append_printf(str, "?%u → $'%s'", i, value->text);
 	}
 	return g_string_free(g_steal_pointer(&str), FALSE);
 }
@@ -255,6 +261,39 @@ xb_value_bindings_bind_val(XbValueBindings *self, guint idx, guint32 val)
 	_self->values[idx].destroy_func = NULL;
 }
 
+/* private */
+void
+xb_value_bindings_bind_indexed_str(XbValueBindings *self,
+				   guint idx,
+				   const gchar *str,
+				   guint32 val)
+{
+	RealValueBindings *_self = (RealValueBindings *)self;
+
+	g_return_if_fail(self != NULL);
+	g_return_if_fail(str != NULL);
+	g_return_if_fail(idx < G_N_ELEMENTS(_self->values));
+
+	xb_value_bindings_clear_index(self, idx);
+
+	_self->values[idx].kind = KIND_INDEXED_TEXT;
+	_self->values[idx].text = (gchar *)str;
+	_self->values[idx].indexed = val;
+}
+
+/* private */
+const gchar *
+xb_value_bindings_get_str(XbValueBindings *self, guint idx)
+{
+	RealValueBindings *_self = (RealValueBindings *)self;
+
+	if (!xb_value_bindings_is_bound(self, idx))
+		return NULL;
+	if (_self->values[idx].kind != KIND_TEXT && _self->values[idx].kind != KIND_INDEXED_TEXT)
+		return NULL;
+	return _self->values[idx].text;
+}
+
 /**
  * xb_value_bindings_lookup_opcode:
  * @self: an #XbValueBindings
@@ -295,6 +334,13 @@ xb_value_bindings_lookup_opcode(XbValueBindings *self, guint idx, XbOpcode *opco
 			       _self->values[idx].integer,
 			       NULL);
 		break;
+	case KIND_INDEXED_TEXT:
+		xb_opcode_init(opcode_out,
+			       XB_OPCODE_KIND_INDEXED_TEXT,
+			       _self->values[idx].text,
+			       _self->values[idx].indexed,
+			       NULL);
+		break;
 	case KIND_NONE:
 	default:
 		g_assert_not_reached();
@@ -337,6 +383,12 @@ xb_value_bindings_copy_binding(XbValueBindings *self,
 	case KIND_INTEGER:
 		xb_value_bindings_bind_val(dest, dest_idx, _self->values[idx].integer);
 		break;
+	case KIND_INDEXED_TEXT:
+		xb_value_bindings_bind_indexed_str(dest,
+						   dest_idx,
+						   _self->values[idx].text,
+						   _self->values[idx].indexed);
+		break;
 	case KIND_NONE:
 	default:
 		g_assert_not_reached();
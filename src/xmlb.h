@@ -19,6 +19,7 @@
 #include <libxmlb/xb-node.h>
 #include <libxmlb/xb-opcode.h>
 #include <libxmlb/xb-query-context.h>
+#include <libxmlb/xb-query-profile.h>
 #include <libxmlb/xb-silo-export.h>
 #include <libxmlb/xb-silo-query.h>
 #include <libxmlb/xb-silo.h>